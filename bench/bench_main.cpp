@@ -0,0 +1,299 @@
+// text_matcher_bench：CSV解析、图片查找、文言比对、OCR识别与PDF生成热点路径的微基准
+// 夹具在临时目录中本地生成（CSV按线上格式合成，图片用OpenCV把已知文言渲染成PNG），
+// 结果以JSON输出（每项：迭代次数、吞吐量、耗时分位数），便于跨版本比对回归
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <getopt.h>
+#include <opencv2/opencv.hpp>
+#include "csv_utils.h"
+#include "csv_parser.h"
+#include "image_index.h"
+#include "text_matcher.h"
+#include "ocr_processor.h"
+#include "pdf_generator.h"
+
+// 单项基准结果
+struct BenchResult {
+    std::string name;
+    size_t items_per_iter = 1;          // 每次迭代处理的条目数（用于换算吞吐量）
+    std::vector<double> samples_us;     // 每次迭代耗时（微秒）
+};
+
+struct BenchOptions {
+    std::string tessdata_dir = "config/tessdata";
+    std::string json_path;              // 为空时输出到标准输出
+    size_t csv_rows = 20000;
+    double min_seconds = 0.5;           // 每项最少运行时间
+    size_t min_iters = 5;
+    bool skip_ocr = false;
+};
+
+// 至少运行min_iters次且累计min_seconds秒
+static BenchResult run_bench(const std::string& name, size_t items_per_iter, const BenchOptions& options,
+                             const std::function<void()>& body) {
+    BenchResult result;
+    result.name = name;
+    result.items_per_iter = items_per_iter;
+    double total_us = 0;
+    while (result.samples_us.size() < options.min_iters || total_us < options.min_seconds * 1e6) {
+        auto begin = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(end - begin).count();
+        result.samples_us.push_back(us);
+        total_us += us;
+        if (result.samples_us.size() >= 100000) break;
+    }
+    std::cerr << "  " << name << "：" << result.samples_us.size() << "次" << std::endl;
+    return result;
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static void write_json(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        std::vector<double> sorted = r.samples_us;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double us : sorted) total += us;
+        double mean = total / sorted.size();
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+                 "    {\"name\": \"%s\", \"iterations\": %zu, \"items_per_iter\": %zu, "
+                 "\"items_per_sec\": %.1f, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, "
+                 "\"p99_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f}",
+                 r.name.c_str(), sorted.size(), r.items_per_iter,
+                 mean > 0 ? r.items_per_iter * 1e6 / mean : 0.0, mean,
+                 percentile(sorted, 0.5), percentile(sorted, 0.9), percentile(sorted, 0.99),
+                 sorted.front(), sorted.back());
+        out << buf << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+// 各语种的样例文言（OpenCV内置字体只能绘制ASCII，非拉丁语种使用转写文本，测量的是该语种模型的识别开销）
+struct LangSample {
+    std::string lang;
+    std::string lang_code;
+    std::string text;
+    std::string keyword;    // CSV文言中的语种关键词
+};
+static const std::vector<LangSample> LANG_SAMPLES = {
+    {"英语", "eng", "Vehicle system is starting", "english"},
+    {"法语", "fra", "Le systeme du vehicule demarre", "french"},
+    {"德语", "deu", "Das Fahrzeugsystem startet", "german"},
+    {"意大利语", "ita", "Il sistema del veicolo si avvia", "italian"},
+    {"西班牙语", "spa", "El sistema del vehiculo se inicia", "spanish"},
+    {"葡萄牙语", "por", "O sistema do veiculo esta iniciando", "portuguese"},
+    {"土耳其语", "tur", "Arac sistemi baslatiliyor", "turkish"},
+    {"俄语", "rus", "Sistema avtomobilya zapuskaetsya", "russian"},
+    {"泰语", "tha", "Rabob rot kamlang riam tham ngan", "thai"},
+    {"阿拉伯语", "ara", "Nizam al-sayyara qayd al-tashghil", "arabic"},
+};
+
+// 模拟车机截图：深色文字居中渲染到浅色背景上
+static bool render_text_png(const std::string& path, const std::string& text) {
+    cv::Mat img(160, 1280, CV_8UC3, cv::Scalar(245, 245, 245));
+    cv::putText(img, text, cv::Point(40, 100), cv::FONT_HERSHEY_SIMPLEX, 1.6, cv::Scalar(20, 20, 20), 3, cv::LINE_AA);
+    return cv::imwrite(path, img);
+}
+
+// 与线上格式一致的一行CSV（元数据字段为跨行的引号字段）
+static std::string make_csv_row(size_t i, const LangSample& sample) {
+    std::ostringstream row;
+    row << (24000 + i) << ",,MultiLanguageTable（Operation）,\"车机已启动, 第" << i << "项\","
+        << "\"ScreenID：MM_00_" << (i % 100) << "\nPartID:1_1_" << (i % 7) << "_A_1\nString ID:MM_"
+        << (i / 100) << "_" << (i % 100) << "_04\",确认文言表示," << sample.text << " (" << sample.keyword << "),Y,Y,Y\n";
+    return row.str();
+}
+
+static void print_usage() {
+    std::cout << "用法：./text_matcher_bench [--tessdata <模型目录>] [--json <输出文件>] [--rows <CSV行数>] "
+                 "[--min-time <秒>] [--skip-ocr]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    static const struct option LONG_OPTIONS[] = {
+        {"tessdata", required_argument, nullptr, 't'},
+        {"json", required_argument, nullptr, 'j'},
+        {"rows", required_argument, nullptr, 'r'},
+        {"min-time", required_argument, nullptr, 'm'},
+        {"skip-ocr", no_argument, nullptr, 's'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:j:r:m:sh", LONG_OPTIONS, nullptr)) != -1) {
+        switch (opt) {
+            case 't': options.tessdata_dir = optarg; break;
+            case 'j': options.json_path = optarg; break;
+            case 'r': options.csv_rows = (size_t)atol(optarg); break;
+            case 'm': options.min_seconds = atof(optarg); break;
+            case 's': options.skip_ocr = true; break;
+            default:
+                print_usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    // 1. 生成夹具
+    char dir_template[] = "/tmp/text_matcher_bench_XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        std::cerr << "无法创建夹具目录！" << std::endl;
+        return -1;
+    }
+    std::string fixture_dir = dir_template;
+    std::string img_dir = fixture_dir + "/images";
+    create_dir(img_dir);
+    std::cerr << "夹具目录：" << fixture_dir << std::endl;
+
+    std::string csv_path = fixture_dir + "/strings.csv";
+    std::vector<std::string> csv_lines;
+    {
+        std::ofstream csv(csv_path, std::ios::out | std::ios::binary);
+        for (size_t i = 0; i < options.csv_rows; i++) {
+            csv_lines.push_back(make_csv_row(i, LANG_SAMPLES[i % LANG_SAMPLES.size()]));
+            csv << csv_lines.back();
+        }
+    }
+
+    // 图片目录：每种语种一张真实截图，其余为同名规则的空文件（只用于索引查找）
+    for (const auto& sample : LANG_SAMPLES) {
+        render_text_png(img_dir + "/BENCH_" + sample.lang_code + ".png", sample.text);
+    }
+    for (size_t i = 0; i < options.csv_rows; i++) {
+        std::string sub_dir = img_dir + "/screen_" + std::to_string(i % 32);
+        if (i < 32) create_dir(sub_dir);
+        std::ofstream(sub_dir + "/MM_" + std::to_string(i / 100) + "_" + std::to_string(i % 100) + "_04_01.png");
+    }
+
+    std::vector<BenchResult> results;
+
+    // 2. CSV：单条记录拆分、元数据提取、整文件解析
+    std::cerr << "CSV解析基准：" << std::endl;
+    std::vector<CsvField> fields;
+    results.push_back(run_bench("split_csv_record", csv_lines.size(), options, [&]() {
+        for (const auto& line : csv_lines) split_csv_record(line, fields);
+    }));
+    results.push_back(run_bench("extract_csv_meta", csv_lines.size(), options, [&]() {
+        std::ostringstream log;
+        for (const auto& line : csv_lines) {
+            split_csv_record(line, fields);
+            CsvMeta meta = extract_csv_meta(fields, line, 1, log);
+        }
+    }));
+    results.push_back(run_bench("parse_csv_rows", options.csv_rows, options, [&]() {
+        parse_csv_rows(csv_path, [](CsvMeta&) {});
+    }));
+
+    // 3. 图片查找：建立索引与按String ID查找
+    std::cerr << "图片索引基准：" << std::endl;
+    ImageIndex index;
+    results.push_back(run_bench("build_image_index", options.csv_rows, options, [&]() {
+        std::cout.setstate(std::ios::failbit);
+        build_image_index(img_dir, index);
+        std::cout.clear();
+    }));
+    std::vector<std::string> string_ids;
+    for (size_t i = 0; i < options.csv_rows; i++) {
+        string_ids.push_back("MM_" + std::to_string(i / 100) + "_" + std::to_string(i % 100) + "_04");
+    }
+    results.push_back(run_bench("match_image_by_string_id", string_ids.size(), options, [&]() {
+        for (const auto& id : string_ids) match_image_by_string_id(index, id);
+    }));
+
+    // 4. 文言比对：期望文言与含噪声的识别文本
+    std::cerr << "文言比对基准：" << std::endl;
+    std::vector<std::pair<std::string, std::string>> match_pairs;
+    for (const auto& sample : LANG_SAMPLES) {
+        std::string noisy = "12:45 " + sample.text + " OK";
+        std::replace(noisy.begin(), noisy.end(), 'e', 'c');
+        match_pairs.emplace_back(sample.text, noisy);
+    }
+    results.push_back(run_bench("match_expected_text", match_pairs.size(), options, [&]() {
+        for (size_t i = 0; i < match_pairs.size(); i++) {
+            match_expected_text(match_pairs[i].first, match_pairs[i].second, LANG_SAMPLES[i].lang_code);
+        }
+    }));
+
+    // 5. OCR：各语种单张图片识别（引擎先预热，不计模型加载时间）
+    if (!options.skip_ocr && init_ocr_engine(options.tessdata_dir)) {
+        std::cerr << "OCR识别基准：" << std::endl;
+        for (const auto& sample : LANG_SAMPLES) {
+            if (access((options.tessdata_dir + "/" + sample.lang_code + ".traineddata").c_str(), R_OK) != 0) {
+                std::cerr << "  跳过" << sample.lang_code << "（未找到模型）" << std::endl;
+                continue;
+            }
+            CsvMeta meta;
+            meta.line_num = 1;
+            meta.lang = sample.lang;
+            meta.lang_id = lang_id_of(meta.lang);
+            meta.lang_text = sample.text;
+            meta.string_id = "BENCH_" + sample.lang_code;
+            DecodedImage img = decode_image(img_dir + "/BENCH_" + sample.lang_code + ".png");
+            process_image(img, meta, 0.8);
+            results.push_back(run_bench("process_image/" + sample.lang_code, 1, options, [&]() {
+                process_image(img, meta, 0.8);
+            }));
+        }
+        release_ocr_engine();
+    } else if (!options.skip_ocr) {
+        std::cerr << "OCR引擎初始化失败，跳过识别基准（可用--tessdata指定模型目录）" << std::endl;
+    }
+
+    // 6. PDF：N条结果（图片在各语种截图间轮换）
+    std::cerr << "PDF生成基准：" << std::endl;
+    for (size_t n : {100, 1000}) {
+        std::vector<OcrResult> pdf_results;
+        for (size_t i = 0; i < n; i++) {
+            const LangSample& sample = LANG_SAMPLES[i % LANG_SAMPLES.size()];
+            OcrResult res;
+            res.line_num = (int)i + 1;
+            res.seq_id = std::to_string(24000 + i);
+            res.string_id = "MM_" + std::to_string(i) + "_04";
+            res.lang = sample.lang;
+            res.lang_code = sample.lang_code;
+            res.text = sample.text;
+            res.img_id = "BENCH_" + sample.lang_code + ".png";
+            res.img_path = img_dir + "/" + res.img_id;
+            res.annotated_img = res.img_path;
+            res.is_ok = (i % 10 != 0);
+            res.match_score = res.is_ok ? 1.0 : 0.5;
+            res.count = 1;
+            res.box = {40, 60, 800, 60};
+            pdf_results.push_back(res);
+        }
+        std::string pdf_path = fixture_dir + "/report_" + std::to_string(n) + ".pdf";
+        results.push_back(run_bench("generate_pdf/" + std::to_string(n), n, options, [&]() {
+            std::cout.setstate(std::ios::failbit);
+            generate_pdf(pdf_path, pdf_results);
+            std::cout.clear();
+        }));
+    }
+
+    // 7. 输出
+    if (options.json_path.empty()) {
+        write_json(std::cout, results);
+    } else {
+        std::ofstream out(options.json_path, std::ios::out | std::ios::trunc);
+        write_json(out, results);
+        std::cerr << "结果已写入：" << options.json_path << std::endl;
+    }
+    return 0;
+}
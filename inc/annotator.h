@@ -0,0 +1,23 @@
+#ifndef ANNOTATOR_H
+#define ANNOTATOR_H
+
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "data_struct.h"
+
+// 标注图片配置
+struct AnnotateConfig {
+    std::string out_dir;        // 标注图片输出目录（为空则不生成）
+    int max_side = 1600;        // 最长边上限（像素，超出时先缩小再绘制）
+    int jpeg_quality = 80;      // JPEG压缩质量
+};
+
+// 标注图片路径：输出目录/<图片名>_<记录键哈希>.jpg（同一记录在多次运行中路径不变）
+std::string annotated_image_path(const AnnotateConfig& config, const OcrResult& res);
+
+// 在图片副本上绘制识别框：文本行细框，单词框按置信度着色，与期望文言匹配的片段高亮
+// （通过绿色、未通过红色），缩放到max_side以内后编码为JPEG写出；
+// 成功返回true，res.annotated_img改为标注图片路径（报告仍嵌入原图，识别框以矢量叠加）
+bool render_annotated_image(const cv::Mat& image, OcrResult& res, const AnnotateConfig& config);
+
+#endif // ANNOTATOR_H
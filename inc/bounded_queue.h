@@ -0,0 +1,62 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// 有界阻塞队列（流水线各阶段之间使用）：满时push阻塞，空时pop阻塞；
+// close后不再接受新元素，pop取完剩余元素后返回false
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1), m_closed(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed;
+};
+
+#endif // BOUNDED_QUEUE_H
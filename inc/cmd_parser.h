@@ -2,13 +2,40 @@
 #define CMD_PARSER_H
 
 #include <string>
+#include <vector>
 
 // 命令行参数结构体
 struct CmdParams {
-    std::string csv_path;        // CSV文件路径（必填）
-    std::string img_dir;         // 图片目录路径（必填）
-    std::string pdf_output;      // PDF输出路径（必填）
+    std::string csv_path;        // CSV文件路径（必填，服务模式除外）
+    std::string img_dir;         // 图片目录路径（必填，服务模式除外）
+    std::string pdf_output;      // PDF输出路径（必填，服务模式除外）
+    std::string tessdata_dir;    // 模型目录（默认：TESSDATA_PREFIX，其次./config/tessdata）
+    std::string serve_socket;    // 服务模式：监听的Unix域套接字路径
+    size_t serve_max_csv_mb = 64; // 服务模式：作业直接发送的CSV内容上限（MB）
+    int shard_index = 0;         // 分片运行（--shard i/N）：本进程处理的分片号
+    int shard_count = 1;         // 分片总数（1=不分片）
+    bool merge = false;          // 合并模式：汇总分片结果文件生成最终报告
+    std::vector<std::string> merge_inputs; // 合并模式的分片结果文件
     double confidence = 0.8;     // 识别置信度阈值（默认0.8）
+    int threads = 0;             // 识别线程数（0=按CPU核数）
+    bool preload_engines = false; // 是否在工作线程启动时预加载全部语种引擎
+    bool preprocess = true;      // 识别前是否做图像预处理
+    int invert = -1;             // 反色：-1自动，0关闭，1开启
+    bool deskew = false;         // 是否做倾斜校正
+    std::string region_file;     // ROI区域表文件（可选）
+    bool learn_regions = false;  // 是否从整页识别结果中学习区域并写回区域表
+    std::string cache_dir;       // 识别结果缓存目录（默认：输出目录/.ocr_cache）
+    bool use_cache = true;       // 是否使用识别结果缓存
+    size_t cache_max_mb = 1024;  // 缓存数据上限（MB）
+    bool incremental = false;    // 增量模式：与上次运行清单比对，只识别变化的记录
+    bool resume = false;         // 从结果日志恢复中断的运行，已完成的记录不再识别
+    std::string report_images = "thumb"; // 报告图片：thumb缩略图（FAIL附原图）、full原图、none不嵌入
+    std::string font_path;       // 报告字体（TrueType，可选，优先于内置候选字体）
+    std::string lang_keywords;   // 语种关键词表文件（可选，默认使用内置表）
+    bool cascade = true;         // 两级识别：快速配置先识别，未通过的再用精确配置识别
+    bool annotate = true;        // 生成标注图片（识别框与匹配片段），报告在原图上叠加识别框
+    std::string trace_path;      // Chrome追踪文件输出路径（可选）
+    bool print_stats = false;    // 结束时打印阶段耗时统计
     bool is_valid = false;       // 参数是否有效
 };
 
@@ -2,19 +2,17 @@
 #define CSV_PARSER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <functional>
 #include "data_struct.h"
+#include "image_index.h"
 
-// 解析CSV文件，返回 语种->元数据列表 映射
-std::map<std::string, std::vector<CsvMeta>> parse_csv(const std::string& csv_path);
+// 逐行流式解析CSV，每得到一条有效记录即回调，返回有效记录数
+int parse_csv_rows(const std::string& csv_path, const std::function<void(CsvMeta&)>& on_row);
 
-// 按语种拆分任务
-std::vector<LangTask> split_tasks_by_lang(
-    const std::map<std::string, std::vector<CsvMeta>>& csv_data,
-    const std::string& img_dir,
-    double confidence,
-    const std::string& output_dir
-);
+// 解析内存中的CSV内容（与parse_csv_rows相同的规则与回调顺序）
+int parse_csv_data(std::string_view data, const std::function<void(CsvMeta&)>& on_row);
 
 #endif // CSV_PARSER_H
\ No newline at end of file
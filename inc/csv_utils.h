@@ -2,89 +2,95 @@
 #define CSV_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <functional>
+#include <ostream>
 #include <algorithm>  // 新增：std::remove依赖
-#include <cstdio>     // 新增：popen/pclose依赖
 #include <unistd.h>   // 新增：access依赖
 #include "data_struct.h"
+#include "image_index.h"
 
-// 声明为inline，避免重复定义
-inline std::vector<std::string> parse_csv_line(const std::string& line) {
-    std::vector<std::string> fields;
-    std::string current_field;
+// CSV字段：指向原始缓冲区的视图（不拷贝）
+struct CsvField {
+    std::string_view text;      // 字段内容（无内部引号时已去掉外层引号）
+    bool has_quotes = false;    // 含需要还原的引号（""转义或字段中间的引号）
+};
+
+// 按逗号拆分一条记录（引号内的逗号与换行属于字段内容）
+inline void split_csv_record(std::string_view record, std::vector<CsvField>& fields) {
+    fields.clear();
+    size_t field_begin = 0;
+    size_t quote_num = 0;
     bool in_quote = false;
 
-    for (char c : line) {
-        if (c == '"' && !in_quote) {
-            in_quote = true;
-            continue;
-        } else if (c == '"' && in_quote) {
-            in_quote = false;
-            continue;
+    auto add_field = [&](size_t end) {
+        CsvField field;
+        field.text = record.substr(field_begin, end - field_begin);
+        if (quote_num == 2 && field.text.size() >= 2 && field.text.front() == '"' && field.text.back() == '"') {
+            field.text = field.text.substr(1, field.text.size() - 2);
+        } else {
+            field.has_quotes = (quote_num > 0);
+        }
+        fields.push_back(field);
+    };
+
+    for (size_t i = 0; i < record.size(); i++) {
+        char c = record[i];
+        if (c == '"') {
+            in_quote = !in_quote;
+            quote_num++;
+        } else if (c == ',' && !in_quote) {
+            add_field(i);
+            field_begin = i + 1;
+            quote_num = 0;
         }
+    }
+    add_field(record.size());
+}
+
+// 还原字段内容：去掉引号，引号内的""还原为"
+inline std::string csv_field_string(const CsvField& field) {
+    if (!field.has_quotes) return std::string(field.text);
 
-        if (c == ',' && !in_quote) {
-            fields.push_back(current_field);
-            current_field.clear();
+    std::string value;
+    value.reserve(field.text.size());
+    bool in_quote = false;
+    for (size_t i = 0; i < field.text.size(); i++) {
+        char c = field.text[i];
+        if (c != '"') {
+            value += c;
+        } else if (in_quote && i + 1 < field.text.size() && field.text[i + 1] == '"') {
+            value += '"';
+            i++;
         } else {
-            current_field += c;
+            in_quote = !in_quote;
         }
     }
-    fields.push_back(current_field);
-    return fields;
+    return value;
 }
 
-inline std::string extract_target_text(const std::string& line) {
-    std::string start_marker = "确认文言表示,";
+inline std::string extract_target_text(std::string_view line) {
+    std::string_view start_marker = "确认文言表示,";
     size_t start_pos = line.find(start_marker);
-    if (start_pos == std::string::npos) return "";
+    if (start_pos == std::string_view::npos) return "";
     start_pos += start_marker.length();
 
-    std::string end_marker = "Y,Y,Y";
+    std::string_view end_marker = "Y,Y,Y";
     size_t end_pos = line.find(end_marker, start_pos);
-    if (end_pos == std::string::npos) return "";
-
-    std::string target_text = line.substr(start_pos, end_pos - start_pos);
-    target_text.erase(0, target_text.find_first_not_of(" \t\n\r"));
-    target_text.erase(target_text.find_last_not_of(" \t\n\r") + 1);
-
-    return target_text;
-}
-
-inline std::string match_image_by_string_id(const std::string& img_dir, const std::string& string_id) {
-    std::string cmd = "find " + img_dir + " -name '" + string_id + "*' -name '*.png' | head -1";
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) return "";
+    if (end_pos == std::string_view::npos) return "";
 
-    char buffer[256] = {0};  // 初始化缓冲区，避免脏数据
-    std::string img_path;
-    // 修复：fgets返回空时直接返回，避免空字符串处理
-    if (fgets(buffer, sizeof(buffer) - 1, pipe) != nullptr) {
-        img_path = buffer;
-        // 修复：正确移除换行符（迭代器类型匹配）
-        img_path.erase(
-            std::remove(img_path.begin(), img_path.end(), '\n'), 
-            img_path.end()
-        );
-        // 额外：移除回车符（兼容Windows换行）
-        img_path.erase(
-            std::remove(img_path.begin(), img_path.end(), '\r'), 
-            img_path.end()
-        );
-    }
-    pclose(pipe);
-    return img_path;
+    std::string_view target_text = line.substr(start_pos, end_pos - start_pos);
+    size_t first = target_text.find_first_not_of(" \t\n\r");
+    if (first == std::string_view::npos) return "";
+    size_t last = target_text.find_last_not_of(" \t\n\r");
+    return std::string(target_text.substr(first, last - first + 1));
 }
 
 // 非inline函数声明（实现放在csv_parser.cpp）
-CsvMeta extract_csv_meta(const std::vector<std::string>& fields, const std::string& original_line, int line_num);
-std::map<std::string, std::vector<CsvMeta>> parse_csv(const std::string& csv_path);
-std::vector<LangTask> split_tasks_by_lang(
-    const std::map<std::string, std::vector<CsvMeta>>& csv_data,
-    const std::string& img_dir,
-    double confidence,
-    const std::string& output_dir
-);
+// 从一条记录提取元数据（record为整条原始记录，告警写入log）
+CsvMeta extract_csv_meta(const std::vector<CsvField>& fields, std::string_view record, int line_num, std::ostream& log);
+int parse_csv_rows(const std::string& csv_path, const std::function<void(CsvMeta&)>& on_row);
 
 #endif // CSV_UTILS_H
\ No newline at end of file
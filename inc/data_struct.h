@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include "record_store.h"
 
 // 语种编码映射（Tesseract标准编码）
 const std::map<std::string, std::string> LANG_CODE_MAP = {
@@ -23,53 +25,69 @@ const std::map<std::string, std::string> LANG_CODE_MAP = {
 struct CsvMeta {
     int line_num;               // CSV行号
     std::string seq_id;         // 序号（如24438）
-    std::string module;         // 模块（如MultiLanguageTable（Operation））
+    InternedString module;      // 模块（如MultiLanguageTable（Operation））
     std::string desc;           // 描述（如车机已启动）
     std::string lang_text;      // 目标文言（精准提取的内容）
     std::string string_id;      // 核心标识（如MM_00_06_04）
-    std::string screen_id;      // 屏幕ID（如MM_00_06_04）
-    std::string part_id;        // 部件ID（如1_1_1_A_1）
-    std::string lang;           // 语种（自动识别，如英语）
+    InternedString screen_id;   // 屏幕ID（如MM_00_06_04）
+    InternedString part_id;     // 部件ID（如1_1_1_A_1）
+    InternedString lang;        // 语种（自动识别，如英语）
+    LangId lang_id = LANG_UNKNOWN; // 语种枚举（与lang对应）
+};
+
+// 报告用图片（定义见pdf_generator.h）
+struct ReportImage;
+
+// 判定识别结果的层级
+enum OcrTier {
+    OCR_TIER_NONE = 0,          // 未得到识别结果
+    OCR_TIER_FAST = 1,          // 快速配置（快速模型、关闭词典）
+    OCR_TIER_ACCURATE = 2       // 精确配置
+};
+
+// 识别框层级
+enum OcrBoxLevel {
+    OCR_BOX_LINE = 0,           // 文本行
+    OCR_BOX_WORD = 1            // 单词
+};
+
+// 识别出的文本行/单词框（原图坐标）
+struct OcrTextBox {
+    int level = OCR_BOX_WORD;   // OcrBoxLevel
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+    float confidence = 0;       // 识别置信度（0~1）
+    std::string text;           // 单词文本（行框为空，行文本由其后的单词组成）
+    bool matched = false;       // 属于与期望文言匹配的片段
 };
 
 // 单条OCR识别结果
 struct OcrResult {
     // 基础字段
-    std::string lang;          // 语种（中文名称，如：英语）
-    std::string lang_code;     // 语种编码（如：eng）
+    InternedString lang;       // 语种（中文名称，如：英语）
+    InternedString lang_code;  // 语种编码（如：eng）
     std::string img_id;        // 图片ID（完整文件名，如MM_02_01_01_04）
     std::string text;          // 识别文本
-    bool is_ok;                // 识别是否成功
-    int count;                 // 该文本出现次数
-    std::string annotated_img; // 标注后图片路径
-    std::vector<int> box;      // 识别点位框 [x, y, w, h]
+    bool is_ok;                // 识别是否成功（置信度与文言相似度均达到阈值）
+    double confidence = 0;     // 平均识别置信度（0~1）
+    double match_score = 0;    // 期望文言与识别文本的相似度（0~1）
+    int count;                 // 该文本出现次数（全部结果汇总后的最终值）
+    std::string img_path;      // 原图路径（FAIL附录按原图分组并在原图上框出位置）
+    std::string annotated_img; // 标注后图片路径（未生成标注图片时为原图路径）
+    std::vector<int> box;      // 识别点位框 [x, y, w, h]（匹配到期望文言时为匹配片段的范围）
+    std::vector<OcrTextBox> text_boxes; // 行框与单词框（每个行框后紧跟该行的单词框）
+    int tier = OCR_TIER_NONE;  // 判定该结果的识别层级（OcrTier）
+    std::shared_ptr<const ReportImage> report_image; // 报告用图片（解码阶段生成，写入报告后释放；为空时从文件读取）
     
     // CSV元数据字段
+    int line_num = 0;           // CSV行号（报告按此排序）
     std::string seq_id;         // CSV序号（24438）
     std::string string_id;      // String ID（MM_00_06_04）
-    std::string screen_id;      // ScreenID
-    std::string part_id;        // PartID
+    InternedString screen_id;   // ScreenID
+    InternedString part_id;     // PartID
     std::string doc_position;   // 文档位置（CSV行号+模块）
 };
 
-// 多语种任务结构体（线程池用）- 完全移除mutex
-struct LangTask {
-    std::string lang;                      // 语种（中文名称）
-    std::string lang_code;                 // 语种编码（Tesseract用）
-    std::vector<std::pair<std::string, CsvMeta>> img_meta_list; // 图片路径+CSV元数据
-    double confidence_threshold;           // 识别置信度阈值
-    std::string output_dir;                // 本地输出目录（替代U盘）
-
-    // 显式声明默认构造/拷贝/移动（确保编译器生成）
-    LangTask() = default;
-    LangTask(const LangTask&) = default;
-    LangTask(LangTask&&) = default;
-    LangTask& operator=(const LangTask&) = default;
-    LangTask& operator=(LangTask&&) = default;
-    ~LangTask() = default;
-};
-
-// 全局统计：文本出现次数
-extern std::map<std::string, int> g_text_count_map;
-
 #endif // DATA_STRUCT_H
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef HASH_UTILS_H
+#define HASH_UTILS_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+// 64位哈希（MurmurHash64A），用于内容寻址缓存、清单比对与分片
+inline uint64_t hash_bytes(const void* data, size_t len, uint64_t seed = 0) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = seed ^ (len * m);
+
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + (len / 8) * 8;
+    for (; p != end; p += 8) {
+        uint64_t k;
+        memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+        case 7: h ^= (uint64_t)p[6] << 48; // fall through
+        case 6: h ^= (uint64_t)p[5] << 40; // fall through
+        case 5: h ^= (uint64_t)p[4] << 32; // fall through
+        case 4: h ^= (uint64_t)p[3] << 24; // fall through
+        case 3: h ^= (uint64_t)p[2] << 16; // fall through
+        case 2: h ^= (uint64_t)p[1] << 8;  // fall through
+        case 1: h ^= (uint64_t)p[0];
+                h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+inline uint64_t hash_string(const std::string& text, uint64_t seed = 0) {
+    return hash_bytes(text.data(), text.size(), seed);
+}
+
+// 计算文件内容哈希（内存映射读取），失败返回false
+bool hash_file(const std::string& path, uint64_t& hash);
+
+// 哈希值的16位十六进制表示
+std::string hash_to_hex(uint64_t hash);
+
+#endif // HASH_UTILS_H
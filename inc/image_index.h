@@ -0,0 +1,44 @@
+#ifndef IMAGE_INDEX_H
+#define IMAGE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+
+// 图片目录中的一个文件（按文件名排序，便于前缀查找）
+struct ImageEntry {
+    std::string name;           // 文件名（如MM_00_06_04_01.png）
+    unsigned int dir_idx;       // 所在目录在ImageIndex::dirs中的下标
+};
+
+// 目录快照（用于判断缓存的索引是否仍然有效）
+struct ImageDirStamp {
+    std::string path;           // 目录完整路径
+    long mtime_sec;             // 目录修改时间（增删文件会更新）
+    long mtime_nsec;
+};
+
+// 图片目录索引：一次递归扫描，之后按String ID前缀在内存中查找
+struct ImageIndex {
+    std::string root;                   // 扫描根目录
+    std::vector<ImageDirStamp> dirs;    // 扫描到的所有目录
+    std::vector<ImageEntry> entries;    // 按文件名排序的文件列表
+};
+
+// 递归扫描图片目录建立索引（顶层子目录并行扫描）
+bool build_image_index(const std::string& img_dir, ImageIndex& index);
+
+// 优先复用缓存文件中的索引（目录未变化时），否则重新扫描并写回缓存
+bool load_or_build_image_index(const std::string& img_dir, const std::string& cache_path, ImageIndex& index);
+
+// 索引中的所有目录自建立以来均未变化（增删文件会更新目录修改时间）
+bool image_index_is_fresh(const ImageIndex& index);
+
+// 保存/加载索引缓存文件
+bool save_image_index(const ImageIndex& index, const std::string& cache_path);
+bool load_image_index(const std::string& cache_path, ImageIndex& index);
+
+// 按String ID查找图片：返回文件名以该ID开头的第一张PNG（按文件名排序），未找到返回空串
+std::string match_image_by_string_id(const ImageIndex& index, const std::string& string_id);
+
+#endif // IMAGE_INDEX_H
@@ -0,0 +1,34 @@
+#ifndef JOB_SERVER_H
+#define JOB_SERVER_H
+
+#include <string>
+#include "thread_pool.h"
+#include "pdf_generator.h"
+
+// 常驻服务配置
+struct ServeConfig {
+    std::string socket_path;        // Unix域套接字路径
+    double confidence = 0.8;        // 默认识别置信度阈值（作业可单独指定）
+    ReportLayout report_layout;     // 报告版式
+    bool annotate = true;           // 指定了output的作业在PDF所在目录/annotated下生成标注图片
+    size_t max_csv_bytes = 64 * 1024 * 1024; // csv_data内容上限（字节），超出时拒绝作业
+};
+
+// 常驻服务：线程池（及各线程的常驻引擎）与图片目录索引在作业之间保持常驻，
+// 通过Unix域套接字接收作业并流式返回结果；多个作业同时运行时平分线程池的在途识别单元。
+//
+// 请求（每行"键 值"，以end结束）：
+//   csv <CSV路径>            或  csv_data <字节数>，下一行起为该长度的CSV内容（不超过max_csv_bytes）
+//   images <图片目录>
+//   output <PDF输出路径>      （可选，不指定则只返回结果）
+//   threshold <置信度>        （可选）
+//   end
+// 响应（制表符分隔）：
+//   ACCEPTED <作业号>
+//   RESULT <识别结果字段...>  （按CSV行号顺序，每条结果写入后立即返回，字段同运行清单）
+//   DONE <有效记录数> <结果数> <未找到图片数> <耗时毫秒>   或   ERROR <原因>
+//
+// 收到SIGINT/SIGTERM后停止接收新作业，等待进行中的作业结束后返回
+bool run_job_server(const ServeConfig& config, ThreadPool& pool);
+
+#endif // JOB_SERVER_H
@@ -0,0 +1,27 @@
+#ifndef LANG_DETECT_H
+#define LANG_DETECT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 语种关键词：文言中出现该关键词（忽略大小写）即判为该语种；
+// 多个语种同时命中时，表中先出现的语种优先
+struct LangKeyword {
+    std::string lang;           // 语种（中文名称，须在LANG_CODE_MAP中）
+    std::string keyword;        // 关键词（UTF-8）
+};
+
+// 内置关键词表
+const std::vector<LangKeyword>& default_lang_keywords();
+
+// 加载关键词表文件（每行：语种,关键词；#开头为注释；语种优先级按首次出现顺序）
+bool load_lang_keywords(const std::string& path, std::vector<LangKeyword>& keywords);
+
+// 用关键词表构建识别自动机（解析CSV前调用；未调用时使用内置表）
+bool set_lang_keywords(const std::vector<LangKeyword>& keywords);
+
+// 单遍扫描文言判断语种（UTF-8大小写折叠后匹配），均未命中时返回英语
+std::string detect_lang(std::string_view text);
+
+#endif // LANG_DETECT_H
@@ -0,0 +1,29 @@
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// 只读映射的语种模型文件（traineddata）
+struct MappedModel {
+    const char* data = nullptr;
+    size_t size = 0;
+    uint64_t hash = 0;          // 文件内容哈希（识别结果缓存键的一部分）
+};
+
+// 获取语种模型：每个语种的文件只映射一次，所有线程的引擎从同一只读缓冲区初始化；
+// 文件不存在或映射失败时返回false
+bool map_model_file(const std::string& tessdata_dir, const std::string& lang_code, MappedModel& model);
+
+// 已映射的模型文件数与总字节数
+size_t mapped_model_count();
+size_t mapped_model_bytes();
+
+// 解除所有映射（所有引擎创建完毕或释放后调用）
+void unmap_model_files();
+
+// 当前进程常驻内存（字节，读取失败时为0）
+size_t process_rss_bytes();
+
+#endif // MODEL_STORE_H
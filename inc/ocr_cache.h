@@ -0,0 +1,53 @@
+#ifndef OCR_CACHE_H
+#define OCR_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "data_struct.h"
+
+// 缓存键（128位）：由图片内容哈希、语种编码、引擎设置与模型文件哈希共同决定
+struct OcrCacheKey {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+};
+
+// 缓存的识别结果
+struct OcrCacheEntry {
+    std::string text;           // 识别文本
+    double confidence = 0;      // 平均置信度（0~1）
+    std::vector<int> box;       // 识别框 [x, y, w, h]
+    std::vector<OcrTextBox> text_boxes; // 行框与单词框（不含匹配标记，命中后按期望文言重新标记）
+};
+
+// 缓存统计
+struct OcrCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+    size_t data_bytes = 0;
+};
+
+// 生成缓存键
+OcrCacheKey make_ocr_cache_key(uint64_t image_hash, const std::string& lang_code,
+                               const std::string& settings, uint64_t model_hash);
+
+// 打开缓存目录（index.bin为内存映射的开放寻址索引，data.bin为追加写入的结果数据）；
+// max_bytes为数据文件上限，写入后超出即按最近使用时间淘汰（常驻服务中缓存不会无限增长）
+bool ocr_cache_open(const std::string& cache_dir, size_t max_bytes);
+
+// 关闭缓存（必要时淘汰并压缩数据文件）
+void ocr_cache_close();
+
+bool ocr_cache_enabled();
+
+// 查找/写入缓存（线程安全）
+bool ocr_cache_lookup(const OcrCacheKey& key, OcrCacheEntry& entry);
+void ocr_cache_store(const OcrCacheKey& key, const OcrCacheEntry& entry);
+
+// 仅判断是否存在（不计入命中统计）
+bool ocr_cache_contains(const OcrCacheKey& key);
+
+OcrCacheStats ocr_cache_stats();
+
+#endif // OCR_CACHE_H
@@ -2,11 +2,98 @@
 #define OCR_PROCESSOR_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
 #include "data_struct.h"
+#include "region_map.h"
 
-// 初始化OCR引擎（Tesseract）
+// 已解码的图片（流水线解码阶段产出）
+struct DecodedImage {
+    std::string path;           // 图片路径
+    uint64_t content_hash = 0;  // 文件内容哈希（识别结果缓存键，读取失败时为0）
+    cv::Mat image;              // 解码后的BGR图像（解码失败或跳过解码时为空）
+    std::vector<unsigned char> bytes; // 文件内容（跳过解码时保留，需要像素时从内存解码，不再读盘）
+};
+
+// 识别前图像预处理配置
+struct PreprocessConfig {
+    bool enabled = true;        // 是否启用预处理（关闭时原图直接送识别）
+    bool binarize = true;       // 自适应阈值二值化
+    int block_size = 31;        // 自适应阈值邻域大小（奇数，像素）
+    double thresh_c = 15;       // 自适应阈值偏移
+    int source_dpi = 96;        // 车机截图等效DPI
+    int target_dpi = 300;       // 归一化目标DPI（Tesseract最佳识别分辨率）
+    int max_side = 4000;        // 缩放后最长边上限（像素）
+    int invert = -1;            // 反色：-1自动识别深色主题，0关闭，1开启
+    bool deskew = false;        // 倾斜校正
+};
+
+// 设置预处理配置（线程池启动前调用）
+void set_preprocess_config(const PreprocessConfig& config);
+
+// 按配置预处理图像：灰度化 -> 反色 -> 缩放 -> 二值化 -> 倾斜校正，输出单通道图像；
+// scale_out返回实际缩放比例（用于把识别框换算回原图坐标）
+cv::Mat preprocess_image(const cv::Mat& src, const PreprocessConfig& config, double* scale_out = nullptr);
+
+// 设置两级识别级联（线程池启动前调用）：开启时先用快速配置（模型目录fast/下的同名快速模型、
+// 关闭词典，整页时按稀疏文本识别）识别，置信度或文言相似度低于阈值的再用精确配置重新识别；
+// 只对有快速模型的语种或命中识别区域的记录启用，其余记录直接按精确配置识别
+void set_ocr_cascade(bool enabled);
+
+// 设置ROI识别区域表：命中区域的记录只识别该矩形（单行模式）；
+// learn为true时，未命中区域的记录整页识别后记录目标文言所在行的位置
+void set_region_config(const RegionMap& regions, bool learn);
+
+// 取出本次运行学习到的区域
+RegionMap get_learned_regions();
+
+// 读取图片文件并计算内容哈希；decode为true时同时解码像素
+DecodedImage load_image(const std::string& img_path, bool decode = true);
+
+// 读取并解码图片文件
+DecodedImage decode_image(const std::string& img_path);
+
+// 该图片+记录的识别结果是否已在缓存中
+bool ocr_cache_probe(const DecodedImage& img, const CsvMeta& csv_meta);
+
+// 影响该记录识别结果的设置指纹（语种、预处理、识别区域与模型），用于增量运行比对
+std::string ocr_settings_fingerprint(const CsvMeta& csv_meta);
+
+// 流水线解码阶段使用：读取一次文件，识别结果已缓存时跳过像素解码（保留文件内容）
+DecodedImage load_image_for_ocr(const std::string& img_path, const CsvMeta& csv_meta);
+
+// 跳过解码的图片补解码（优先使用保留的文件内容），返回是否得到像素
+bool ensure_image_decoded(DecodedImage& img);
+
+// 预读图片文件：通知内核异步读入页缓存，不等待（查找阶段调用，解码阶段读取时不再等磁盘）
+void prefetch_image_file(const std::string& img_path);
+
+// 初始化OCR引擎（Tesseract），记录模型目录，各工作线程按需创建自己的引擎
 bool init_ocr_engine(const std::string& tessdata_path = "");
 
+// 设置预加载语种（为空则按需懒加载）
+void set_engine_preload_langs(const std::vector<std::string>& lang_codes);
+
+// 在当前线程预加载所有预加载语种的引擎（工作线程启动时调用）
+bool warm_up_thread_engines();
+
+// 释放当前线程持有的所有引擎（工作线程退出前调用）
+void release_thread_engines();
+
+// 当前已加载的引擎总数（所有线程）
+int get_engine_count();
+
+// 识别单张已解码的图片
+OcrResult process_image(
+    const DecodedImage& img,
+    const CsvMeta& csv_meta,
+    double confidence
+);
+
+// 识别失败时的占位结果（未通过，保留记录元数据，报告、清单与结果日志中不缺行）
+OcrResult make_failed_result(const std::string& img_path, const CsvMeta& csv_meta);
+
 // 识别单张图片，返回标注后的图片路径+识别结果
 OcrResult process_image(
     const std::string& img_path,
@@ -20,4 +107,4 @@ void release_ocr_engine();
 // 递归创建目录
 bool create_dir(const std::string& dir_path);
 
-#endif // OCR_PROCESSOR_H
\ No newline at end of file
+#endif // OCR_PROCESSOR_H
@@ -0,0 +1,26 @@
+#ifndef OCR_SCHEDULER_H
+#define OCR_SCHEDULER_H
+
+#include <vector>
+#include <functional>
+#include "data_struct.h"
+#include "thread_pool.h"
+#include "ocr_processor.h"
+
+// 每个调度单元包含的图片数（同一语种）
+const size_t OCR_UNIT_IMAGE_NUM = 4;
+
+// 已解码、待识别的一张图片及其CSV元数据
+struct OcrJob {
+    DecodedImage img;
+    CsvMeta meta;
+    std::shared_ptr<const ReportImage> report; // 报告用图片（解码阶段生成，识别后随结果交给报告写入器）
+};
+
+// 识别结果的接收方（流水线中为结果队列）
+typedef std::function<void(std::vector<OcrResult>&&)> OcrResultSink;
+
+// 把一组同语种的已解码图片打包为一个线程池任务，识别完成后整组交给sink
+PoolTask make_ocr_unit(std::vector<OcrJob> jobs, const std::string& lang_code, double confidence, OcrResultSink sink);
+
+#endif // OCR_SCHEDULER_H
@@ -0,0 +1,56 @@
+#ifndef PDF_FONTS_H
+#define PDF_FONTS_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <hpdf.h>
+
+// 字体覆盖的码点范围（取自TrueType的cmap表）
+struct FontCoverage {
+    std::vector<std::pair<char32_t, char32_t>> ranges;  // 按起点排序的闭区间
+    int glyph_num = 0;                                  // 字形数（maxp表）
+
+    bool covers(char32_t cp) const;
+};
+
+// 读取TrueType/TTC字体（TTC取第一个字体）的字符覆盖范围，失败返回false
+bool read_font_coverage(const std::string& font_path, FontCoverage& coverage);
+
+// 默认候选字体：模型目录下的pdf.ttf，其后为常见的系统Unicode字体
+std::vector<std::string> default_report_fonts(const std::string& tessdata_dir);
+
+// 报告字体集：候选字体按顺序排列，每段文本使用第一个能完整显示它的字体；
+// 字体在首次用到时加载一次并嵌入（libharu保存时只写入实际用到的字形）
+class PdfFontSet {
+public:
+    PdfFontSet();
+
+    // 检查候选字体（跳过不存在、无法解析或无可见字形的字体）
+    void init(HPDF_Doc pdf, const std::vector<std::string>& font_paths);
+
+    // 选择显示text所用的字体，并记录其中用到的字符
+    HPDF_Font font_for(const std::string& text);
+
+    size_t used_char_count() const { return m_used.size(); }
+    size_t missing_char_count() const { return m_missing.size(); }
+    std::vector<std::string> loaded_fonts() const;
+
+private:
+    struct Candidate {
+        std::string path;
+        FontCoverage coverage;
+        HPDF_Font font = nullptr;
+        bool load_failed = false;
+    };
+
+    HPDF_Font load(Candidate& candidate);
+
+    HPDF_Doc m_pdf;
+    HPDF_Font m_fallback;
+    std::vector<Candidate> m_candidates;
+    std::set<char32_t> m_used;
+    std::set<char32_t> m_missing;
+};
+
+#endif // PDF_FONTS_H
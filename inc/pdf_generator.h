@@ -2,7 +2,103 @@
 #define PDF_GENERATOR_H
 
 #include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <hpdf.h>
+#include <opencv2/opencv.hpp>
 #include "data_struct.h"
+#include "pdf_fonts.h"
+
+// 报告中图片的嵌入方式
+enum ReportImageMode {
+    REPORT_IMAGE_NONE,      // 不嵌入图片，仅表格
+    REPORT_IMAGE_THUMB,     // 表格行内缩略图，FAIL记录的原图附在报告末尾
+    REPORT_IMAGE_FULL       // 表格行内直接使用原图
+};
+
+// 报告版式
+struct ReportLayout {
+    ReportImageMode image_mode = REPORT_IMAGE_THUMB;
+    int thumb_max_side = 240;   // 缩略图最长边（像素）
+    float row_height = 48;      // 表格行高（磅）
+    std::vector<std::string> font_paths; // 候选字体（按优先级，为空时使用default_report_fonts）
+};
+
+// 报告用图片：解码阶段由已解码的图像生成，随识别结果交给报告写入器，报告不再重新读取、解码图片文件
+struct ReportImage {
+    cv::Mat thumb;              // 缩略图（RGB，缩略图模式）
+    cv::Mat full;               // 原图（BGR，与识别共用同一解码缓冲区；JPEG原图直接嵌入文件数据，此处为空）
+    cv::Mat source;             // 解码图像（BGR，仅生成标注图片时保留，绘制后释放）
+    int width = 0;              // 原图尺寸（表格行内按原图坐标叠加识别框）
+    int height = 0;
+};
+
+// 由已解码的图像生成报告用图片（在解码线程调用）；keep_source为true时保留解码图像供标注阶段绘制
+std::shared_ptr<const ReportImage> make_report_image(const std::string& img_path, const cv::Mat& image,
+                                                     const ReportLayout& layout, bool keep_source = false);
+
+// 增量式PDF报告写入器：结果逐条到达时即写入表格行，每页多行；
+// 同一张图片只嵌入一次，多行共用同一个图片对象，各行的识别位置以矢量框叠加在图片上
+class PdfReportWriter {
+public:
+    PdfReportWriter();
+    ~PdfReportWriter();
+
+    PdfReportWriter(const PdfReportWriter&) = delete;
+    PdfReportWriter& operator=(const PdfReportWriter&) = delete;
+
+    // 创建文档并加载字体
+    bool open(const std::string& pdf_path, const ReportLayout& layout = ReportLayout());
+
+    // 追加一条识别结果（表格一行，当前页写满时换页）；结果带有报告用图片时直接使用，否则读取图片文件
+    bool add_result(const OcrResult& res);
+
+    // 设置最终的文本出现次数（保存前补写到各行的"出现次数"列）
+    void set_text_counts(const std::map<std::string, int>& counts);
+
+    // 追加FAIL原图页后保存并关闭文档
+    bool close();
+
+    size_t page_count() const { return m_pages; }
+
+private:
+    // 延后填写的"出现次数"单元格（结果到达时总数未知）
+    struct CountCell {
+        HPDF_Page page;
+        float x;
+        float y;
+        std::string text;
+        int count;
+    };
+
+    // FAIL记录在原图上的位置（附录页标注）
+    struct FailMark {
+        std::string string_id;
+        std::vector<int> box;
+    };
+
+    void set_font(HPDF_Page page, const std::string& text, float size);
+    void draw_text(HPDF_Page page, float x, float y, const std::string& text, float size);
+    HPDF_Page new_table_page();
+    HPDF_Image get_image(const std::string& img_path, bool thumbnail, const ReportImage* src);
+    void add_fail_pages();
+
+    HPDF_Doc m_pdf;
+    PdfFontSet m_fonts;
+    std::string m_path;
+    size_t m_pages;
+    ReportLayout m_layout;
+    HPDF_Page m_page;                               // 当前表格页
+    float m_row_y;                                  // 当前页下一行的上边缘
+    std::map<std::string, HPDF_Image> m_thumbs;     // 图片路径 -> 缩略图对象
+    std::map<std::string, HPDF_Image> m_images;     // 图片路径 -> 原图对象
+    std::map<std::string, cv::Size> m_image_sizes;  // 图片路径 -> 原图尺寸（缩略图叠加识别框用）
+    std::vector<std::string> m_fail_order;          // FAIL图片（按首次出现顺序）
+    std::map<std::string, std::vector<FailMark>> m_fail_marks;
+    std::vector<CountCell> m_count_cells;
+    std::map<std::string, int> m_text_counts;
+};
 
 // 生成PDF报告（图片+结构化表格）
 bool generate_pdf(
@@ -13,4 +109,4 @@ bool generate_pdf(
 // 递归创建目录（递归创建）
 bool create_dir(const std::string& dir_path);
 
-#endif // PDF_GENERATOR_H
\ No newline at end of file
+#endif // PDF_GENERATOR_H
@@ -0,0 +1,47 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+#include <atomic>
+#include <functional>
+#include "image_index.h"
+#include "thread_pool.h"
+#include "run_manifest.h"
+#include "pdf_generator.h"
+#include "result_journal.h"
+#include "annotator.h"
+
+// 流水线配置
+struct PipelineConfig {
+    std::string csv_path;           // CSV文件路径
+    std::string csv_text;           // 内联CSV内容（非空时代替csv_path）
+    std::string pdf_output;         // PDF输出路径（为空则不生成报告）
+    double confidence = 0.8;        // 识别置信度阈值
+    int decode_threads = 2;         // 解码线程数
+    size_t queue_capacity = 64;     // 各阶段之间队列容量（决定峰值内存）
+    size_t max_inflight_units = 0;  // 已提交未完成的识别单元上限（0=线程池线程数*2）
+    const std::atomic<size_t>* inflight_share = nullptr; // 多个作业共用线程池时本作业的在途单元配额（随作业数动态调整，优先于max_inflight_units）
+    ReportLayout report_layout;     // 报告版式（图片嵌入方式等）
+    AnnotateConfig annotate;        // 标注图片（输出目录为空则不生成，报告使用原图）
+    int render_threads = 2;         // 标注图片绘制线程数
+    const RunManifest* prev_manifest = nullptr; // 增量模式：上次运行清单，未变化的记录直接复用结果
+    RunManifest* manifest_out = nullptr;        // 记录本次运行清单（为空则不记录）
+    ResultJournal* journal = nullptr;           // 每写入一条结果即追加到结果日志（为空则不记录）
+    int shard_index = 0;            // 分片运行：只处理shard_of(记录, shard_count) == shard_index的记录
+    int shard_count = 1;
+    std::function<void(const OcrResult&)> on_result; // 每写入一条结果后回调（写入线程中按CSV行号顺序调用）
+};
+
+// 流水线运行统计
+struct PipelineStats {
+    size_t rows = 0;                // CSV有效记录数
+    size_t missing_images = 0;      // 未找到图片的记录数
+    size_t results = 0;             // 写入报告的结果数
+    size_t reused = 0;              // 增量模式下复用上次结果的记录数
+};
+
+// 流式执行：CSV读取 -> 图片查找 -> 解码 -> OCR（线程池） -> 报告写入，
+// 各阶段通过有界队列衔接并同时运行，结果到达即写入PDF页面
+bool run_pipeline(const PipelineConfig& config, const ImageIndex& img_index, ThreadPool& pool, PipelineStats& stats);
+
+#endif // PIPELINE_H
@@ -0,0 +1,68 @@
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+// 紧凑记录：CSV记录与识别结果中大量重复的字段（语种、模块、ScreenID、PartID）
+// 在全局字符串池中只存一份，记录中只保存8字节的引用；语种另以枚举表示，按图片处理时不再查表
+// 池在进程内不释放，只用于取值有限的字段；描述、String ID等基本每行唯一的字段仍为普通字符串
+
+// 驻留一段文本，返回池中的唯一副本（进程内有效，多线程安全）
+const std::string* intern_string(std::string_view text);
+
+// 字符串池统计：不同文本数与占用字节数
+size_t interned_string_count();
+size_t interned_string_bytes();
+
+// 驻留字符串：拷贝只复制引用，相等比较只比较引用
+class InternedString {
+public:
+    InternedString() : m_str(empty_ptr()) {}
+    InternedString(const std::string& text) : m_str(intern_string(text)) {}
+    InternedString(std::string_view text) : m_str(intern_string(text)) {}
+    InternedString(const char* text) : m_str(intern_string(text)) {}
+
+    const std::string& str() const { return *m_str; }
+    operator const std::string&() const { return *m_str; }
+    const char* c_str() const { return m_str->c_str(); }
+    bool empty() const { return m_str->empty(); }
+    size_t size() const { return m_str->size(); }
+
+    bool operator==(const InternedString& other) const { return m_str == other.m_str; }
+    bool operator!=(const InternedString& other) const { return m_str != other.m_str; }
+    bool operator==(const std::string& text) const { return *m_str == text; }
+    bool operator!=(const std::string& text) const { return *m_str != text; }
+    bool operator==(const char* text) const { return *m_str == text; }
+    bool operator!=(const char* text) const { return *m_str != text; }
+
+private:
+    static const std::string* empty_ptr() {
+        static const std::string empty;
+        return &empty;
+    }
+
+    const std::string* m_str;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const InternedString& text) {
+    return out << text.str();
+}
+
+// 语种编号：0为未知语种，其余按LANG_CODE_MAP的顺序从1编号（首次使用时由LANG_CODE_MAP生成，不另维护语种表）
+typedef uint8_t LangId;
+const LangId LANG_UNKNOWN = 0;
+
+// 语种名称（如英语）-> 编号，LANG_CODE_MAP中没有的语种返回LANG_UNKNOWN
+LangId lang_id_of(const std::string& lang);
+
+// 编号总数（含LANG_UNKNOWN），按语种分组的数组以此为大小
+size_t lang_id_count();
+
+// 编号 -> Tesseract语种编码（已驻留，赋给识别结果时不再查池）；未知语种返回空串，不按英文识别
+const InternedString& lang_code_of(LangId id);
+
+#endif // RECORD_STORE_H
@@ -0,0 +1,29 @@
+#ifndef REGION_MAP_H
+#define REGION_MAP_H
+
+#include <string>
+#include <map>
+#include "data_struct.h"
+
+// 识别区域（原图坐标）
+struct RegionRect {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+// 区域表：键为"ScreenID/PartID"、PartID或ScreenID
+typedef std::map<std::string, RegionRect> RegionMap;
+
+// 记录对应的区域键（学习区域时使用，优先ScreenID/PartID组合）
+std::string region_key(const CsvMeta& meta);
+
+// 查找记录的识别区域：依次尝试ScreenID/PartID、PartID、ScreenID
+bool find_region(const RegionMap& regions, const CsvMeta& meta, RegionRect& rect);
+
+// 加载/保存区域表文件（每行：键,x,y,w,h；#开头为注释）
+bool load_region_map(const std::string& path, RegionMap& regions);
+bool save_region_map(const std::string& path, const RegionMap& regions);
+
+#endif // REGION_MAP_H
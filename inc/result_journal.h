@@ -0,0 +1,54 @@
+#ifndef RESULT_JOURNAL_H
+#define RESULT_JOURNAL_H
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <sys/types.h>
+#include "run_manifest.h"
+
+// 结果日志：每条识别结果完成即追加一条清单记录（带校验和），批量fsync；
+// 进程崩溃或报告生成失败后可用--resume从日志恢复，已完成且未变化的记录不再识别
+class ResultJournal {
+public:
+    ResultJournal();
+    ~ResultJournal();
+
+    ResultJournal(const ResultJournal&) = delete;
+    ResultJournal& operator=(const ResultJournal&) = delete;
+
+    // 打开日志：resume为true时读取已有记录（截掉末尾不完整的记录）并在其后追加，否则新建
+    bool open(const std::string& path, bool resume, size_t sync_every = 64, int sync_interval_ms = 1000);
+
+    // 恢复的记录（仅resume打开时有内容）
+    const RunManifest& recovered() const { return m_recovered; }
+
+    // 追加一条记录（线程安全）；与恢复的记录相同的不重复写入，写入失败后不再追加
+    void append(const std::string& key, const ManifestEntry& entry);
+
+    // 写出剩余记录并同步到磁盘
+    bool sync();
+
+    // 关闭日志；remove为true时删除日志文件（运行成功完成后不再需要）
+    bool close(bool remove);
+
+    size_t appended() const { return m_appended; }
+
+private:
+    bool flush_locked();
+
+    std::mutex m_mutex;
+    std::string m_path;
+    int m_fd;
+    std::string m_pending;          // 尚未写出的记录
+    off_t m_good_size;              // 已完整写出的记录末尾（写入失败时截回此处）
+    size_t m_pending_num;
+    size_t m_sync_every;
+    std::chrono::milliseconds m_sync_interval;
+    std::chrono::steady_clock::time_point m_last_sync;
+    RunManifest m_recovered;
+    size_t m_appended;
+    bool m_failed;
+};
+
+#endif // RESULT_JOURNAL_H
@@ -0,0 +1,51 @@
+#ifndef RUN_MANIFEST_H
+#define RUN_MANIFEST_H
+
+#include <string>
+#include <map>
+#include <cstdint>
+#include <iosfwd>
+#include "data_struct.h"
+
+// 清单中的一条记录：CSV记录哈希 + 图片快照 + 上次的识别结果
+struct ManifestEntry {
+    uint64_t row_hash = 0;      // 文言、元数据、识别设置与阈值的哈希
+    std::string img_path;       // 对应图片路径
+    long img_mtime_sec = 0;     // 图片修改时间
+    long img_mtime_nsec = 0;
+    long long img_size = 0;     // 图片大小（字节）
+    uint64_t img_hash = 0;      // 图片内容哈希（0表示未读取）
+    OcrResult result;           // 上次的识别结果
+};
+
+// 运行清单：记录键 -> 清单记录（每次运行结束后写出，增量模式下与本次CSV比对）
+struct RunManifest {
+    std::map<std::string, ManifestEntry> rows;
+};
+
+// 记录键：序号/String ID/语种（不使用行号，插入或删除其他行不影响比对）
+std::string manifest_row_key(const CsvMeta& meta);
+std::string manifest_row_key(const OcrResult& res);
+
+// 记录哈希：文言与元数据、识别设置指纹、置信度阈值任一变化都会改变
+uint64_t manifest_row_hash(const CsvMeta& meta, const std::string& settings, double confidence);
+
+// 读取图片快照（修改时间与大小），失败返回false
+bool stat_image_file(const std::string& img_path, ManifestEntry& entry);
+
+// 记录与图片均未变化时可直接复用上次结果
+bool manifest_entry_unchanged(const ManifestEntry& prev, const ManifestEntry& cur);
+
+// 识别结果的单行文本序列化（制表符分隔，字段内转义）
+void write_result_fields(std::ostream& out, const OcrResult& res);
+bool read_result_fields(const std::string& line, size_t pos, OcrResult& res);
+
+// 清单记录的单行文本序列化（不含换行符）
+void write_manifest_entry(std::ostream& out, const std::string& key, const ManifestEntry& entry);
+bool read_manifest_entry(const std::string& line, std::string& key, ManifestEntry& entry);
+
+// 加载/保存清单文件
+bool load_run_manifest(const std::string& path, RunManifest& manifest);
+bool save_run_manifest(const std::string& path, const RunManifest& manifest);
+
+#endif // RUN_MANIFEST_H
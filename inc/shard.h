@@ -0,0 +1,44 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include "data_struct.h"
+#include "pdf_generator.h"
+
+// 分片：按String ID+语种的稳定哈希把CSV记录分配到count个分片，各机器（或本机多个进程）各处理一片
+struct ShardSpec {
+    int index = 0;
+    int count = 1;
+};
+
+// 解析"i/N"（0 <= i < N），格式错误返回false
+bool parse_shard_spec(const std::string& text, ShardSpec& spec);
+
+// 记录所属分片（与运行环境、CSV中的位置无关）
+int shard_of(const CsvMeta& meta, int shard_count);
+
+// 分片结果文件写入器（文本，每行一条结果：行号 + 运行清单相同的结果字段）
+class ShardResultWriter {
+public:
+    bool open(const std::string& path, const ShardSpec& spec);
+    void add(const OcrResult& res);
+    bool close();
+
+private:
+    std::string m_path;
+    std::string m_tmp_path;
+    std::ofstream m_out;
+    size_t m_count = 0;
+};
+
+// 读取分片结果文件
+bool load_shard_results(const std::string& path, ShardSpec& spec, std::vector<OcrResult>& results);
+
+// 合并各分片结果：按CSV行号排序、重新统计全局出现次数并生成最终PDF；
+// 分片不完整（数量不一致或缺片）时报错返回false
+bool merge_shard_results(const std::vector<std::string>& paths, const std::string& pdf_output,
+                         const ReportLayout& layout, size_t& result_num);
+
+#endif // SHARD_H
@@ -0,0 +1,39 @@
+#ifndef TEXT_COUNTER_H
+#define TEXT_COUNTER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// 分片计数表：按文本哈希分散到多个分片，各分片独立加锁，多个识别线程同时计数互不阻塞
+class TextCounter {
+public:
+    explicit TextCounter(size_t shard_num = 16);
+
+    TextCounter(const TextCounter&) = delete;
+    TextCounter& operator=(const TextCounter&) = delete;
+
+    // 文本出现次数+n
+    void add(const std::string& text, int n = 1);
+
+    // 当前出现次数
+    int get(const std::string& text) const;
+
+    // 合并所有分片（按文本排序，结果与计数顺序无关）
+    std::map<std::string, int> snapshot() const;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, int> counts;
+    };
+
+    Shard& shard_of(const std::string& text) const;
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+#endif // TEXT_COUNTER_H
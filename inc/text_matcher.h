@@ -0,0 +1,28 @@
+#ifndef TEXT_MATCHER_H
+#define TEXT_MATCHER_H
+
+#include <string>
+
+// 期望文言在识别文本中的匹配结果
+struct TextMatch {
+    double score = 0;       // 相似度（1 - 编辑距离/期望长度，取值[0,1]）
+    int distance = -1;      // 最小编辑距离（-1表示未计算/被预过滤拒绝）
+    int begin = 0;          // 匹配片段在规范化识别文本中的码点区间[begin, end)
+    int end = 0;
+};
+
+// 匹配前规范化：NFC组合、去除零宽/方向控制符、大小写折叠、空白归一，
+// 阿拉伯语去除Tatweel与短元音符号并统一Alef/Ya写法，泰语去除字间空白
+std::u32string normalize_for_match(const std::string& text, const std::string& lang_code);
+
+// 两个码点序列的Levenshtein编辑距离（Myers/Hyyrö位并行算法，按64位分块）
+int edit_distance(const std::u32string& a, const std::u32string& b);
+
+// 在text中查找与pattern编辑距离最小的子串（半全局比对）；
+// max_distance>=0时先用字符计数下界预过滤，下界超过该值直接返回distance=-1
+TextMatch find_best_match(const std::u32string& pattern, const std::u32string& text, int max_distance = -1);
+
+// 比对期望文言与识别文本：规范化后在识别文本中定位期望文言并给出相似度
+TextMatch match_expected_text(const std::string& expected, const std::string& recognized, const std::string& lang_code);
+
+#endif // TEXT_MATCHER_H
@@ -2,19 +2,74 @@
 #define THREAD_POOL_H
 
 #include <vector>
-#include <pthread.h>
-#include "data_struct.h"
+#include <deque>
+#include <string>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
-// 线程池初始化
-bool init_thread_pool(int thread_num = 4);
+// 线程池任务
+struct PoolTask {
+    std::string affinity;                   // 亲和键（如语种编码），同键任务尽量交给同一线程
+    size_t weight = 1;                      // 工作量（如图片数），用于均衡分配
+    std::function<void(int worker_id)> run; // 任务体
+};
 
-// 恢复const引用参数
-void submit_tasks(const std::vector<LangTask>& tasks);
+// 带亲和分配与工作窃取的线程池：空闲线程阻塞在条件变量上，每次提交返回独立的完成future
+class ThreadPool {
+public:
+    typedef std::function<void(int worker_id)> ThreadHook;
 
-// 获取所有识别结果
-std::vector<OcrResult> get_all_results();
+    // thread_num<=0时按CPU核数；on_start/on_exit在每个工作线程启动/退出时执行
+    explicit ThreadPool(int thread_num = 0, ThreadHook on_start = nullptr, ThreadHook on_exit = nullptr);
+    ~ThreadPool();
 
-// 销毁线程池
-void destroy_thread_pool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
 
-#endif // THREAD_POOL_H
\ No newline at end of file
+    // 提交一批任务，可多次提交；返回的future在本批全部任务完成后就绪（停止后提交的future带异常）
+    std::shared_future<void> submit(std::vector<PoolTask> tasks);
+
+    // 等待已提交任务全部完成后停止并回收所有线程（可重复调用）
+    void shutdown();
+
+    int size() const { return (int)m_threads.size(); }
+
+private:
+    // 一次提交的完成计数
+    struct Batch {
+        std::atomic<size_t> remaining;
+        std::promise<void> done;
+    };
+    struct Item {
+        PoolTask task;
+        std::shared_ptr<Batch> batch;
+    };
+    // 每个工作线程的本地队列：自己从头部取，其他线程从尾部窃取
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Item> items;
+        size_t load = 0;    // 队列中剩余的工作量
+    };
+
+    void worker_loop(int worker_id);
+    bool pop_local(int worker_id, Item& item);
+    bool steal(int worker_id, const std::string& cur_affinity, Item& item);
+    void finish_item(Item& item);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    ThreadHook m_on_start;
+    ThreadHook m_on_exit;
+
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wake;
+    std::atomic<long> m_queued;     // 所有本地队列中尚未取走的任务数
+    bool m_stop;                    // 受m_wait_mutex保护
+};
+
+#endif // THREAD_POOL_H
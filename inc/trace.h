@@ -0,0 +1,84 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+// 热点阶段
+enum TraceStage {
+    TRACE_LOOKUP,           // 按String ID查找图片
+    TRACE_DECODE,           // 读取并解码图片
+    TRACE_CACHE,            // 查询识别结果缓存
+    TRACE_ENGINE_INIT,      // 加载语种模型、创建引擎
+    TRACE_ENGINE_SWITCH,    // 切换到线程内已加载的其他语种引擎
+    TRACE_PREPROCESS,       // 图像预处理
+    TRACE_RECOGNIZE,        // Tesseract识别
+    TRACE_MATCH,            // 期望文言比对
+    TRACE_ANNOTATE,         // 绘制并写出标注图片
+    TRACE_PDF_EMIT,         // 写入报告表格行
+    TRACE_PDF_SAVE,         // 附录页与保存文档
+    TRACE_TASK,             // 线程池执行任务（忙碌）
+    TRACE_IDLE,             // 线程池等待任务（空闲）
+    TRACE_STAGE_NUM
+};
+
+// 采样的队列深度
+enum TraceCounter {
+    TRACE_Q_ROWS,           // CSV记录队列
+    TRACE_Q_RESOLVED,       // 待解码队列
+    TRACE_Q_DECODED,        // 已解码待分发队列
+    TRACE_Q_RESULTS,        // 识别结果队列
+    TRACE_Q_INFLIGHT,       // 已提交未完成的识别单元
+    TRACE_Q_REORDER,        // 写入阶段等待前序行的结果
+    TRACE_COUNTER_NUM
+};
+
+// 开启记录（线程启动前调用一次）：events为true时各线程把事件写入环形缓冲区（用于导出追踪文件），
+// stats为true时各线程累计分阶段、分语种的耗时直方图；两者都为false时记录点只做一次判断
+void trace_setup(bool events, bool stats, size_t ring_events = 1 << 16);
+
+extern bool g_trace_active;
+inline bool trace_active() { return g_trace_active; }
+
+// 自trace_setup以来的微秒数
+uint64_t trace_now_us();
+
+// 为当前线程命名（追踪文件与统计输出中显示）
+void trace_thread_name(const std::string& name);
+
+// 记录一段耗时，lang_code为空表示不区分语种
+void trace_span(TraceStage stage, uint64_t begin_us, uint64_t end_us, const std::string& lang_code = std::string());
+
+// 记录一次队列深度采样
+void trace_counter(TraceCounter counter, int64_t value);
+
+// 作用域计时：构造时开始，析构时记录
+class TraceScope {
+public:
+    explicit TraceScope(TraceStage stage)
+        : m_stage(stage), m_on(trace_active()), m_lang(nullptr), m_begin(m_on ? trace_now_us() : 0) {}
+    TraceScope(TraceStage stage, const std::string& lang_code)
+        : m_stage(stage), m_on(trace_active()), m_lang(&lang_code), m_begin(m_on ? trace_now_us() : 0) {}
+    ~TraceScope() {
+        if (m_on) trace_span(m_stage, m_begin, trace_now_us(), m_lang ? *m_lang : std::string());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceStage m_stage;
+    bool m_on;
+    const std::string* m_lang;  // 语种编码（须在作用域内保持有效）
+    uint64_t m_begin;
+};
+
+// 导出Chrome/Perfetto追踪文件（JSON，须在各线程停止记录后调用）
+bool trace_write_chrome(const std::string& path);
+
+// 打印分阶段、分语种的耗时直方图，各线程忙碌/空闲时间与队列深度
+void trace_print_stats(std::ostream& out);
+
+#endif // TRACE_H
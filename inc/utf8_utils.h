@@ -0,0 +1,30 @@
+#ifndef UTF8_UTILS_H
+#define UTF8_UTILS_H
+
+#include <string>
+#include <string_view>
+
+// 读取pos处的一个码点并前移pos（非法字节按U+FFFD处理）
+char32_t utf8_next(std::string_view text, size_t& pos);
+
+// UTF-8 -> 码点序列（非法字节按U+FFFD处理）
+std::u32string utf8_decode(const std::string& text);
+
+// 码点序列 -> UTF-8
+std::string utf8_encode(const std::u32string& text);
+void utf8_append(std::string& out, char32_t cp);
+
+// 单个码点的大小写折叠（拉丁/西里尔/希腊字母；turkish为true时I/İ按土耳其语规则）
+char32_t fold_case(char32_t cp, bool turkish = false);
+
+// NFC组合：把"基字符+组合附加符"合成为预组合字符
+// （覆盖LANG_CODE_MAP中各语种用到的拉丁、西里尔与阿拉伯字母组合）
+std::u32string compose_nfc(const std::u32string& text);
+
+// 是否为空白字符（含不间断空格、全角空格等）
+bool is_space_cp(char32_t cp);
+
+// 是否为零宽/方向控制字符（ZWSP、ZWJ、LRM、BOM等）
+bool is_format_cp(char32_t cp);
+
+#endif // UTF8_UTILS_H
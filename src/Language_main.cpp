@@ -1,12 +1,23 @@
 #include <iostream>
 #include "cmd_parser.h"
-#include "csv_parser.h"
 #include "ocr_processor.h"  // 引入OCR函数声明
 #include "pdf_generator.h"
 #include "thread_pool.h"
+#include "pipeline.h"
 #include "data_struct.h"
-
-std::map<std::string, int> g_text_count_map;
+#include "image_index.h"
+#include "ocr_cache.h"
+#include "run_manifest.h"
+#include "result_journal.h"
+#include "lang_detect.h"
+#include "trace.h"
+#include "model_store.h"
+#include "job_server.h"
+#include "shard.h"
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
 
 int main(int argc, char** argv) {
     // 1. 解析命令行参数
@@ -15,47 +26,239 @@ int main(int argc, char** argv) {
         print_usage();
         return -1;
     }
+    // 阶段耗时记录（须在各线程启动前开启）
+    trace_setup(!params.trace_path.empty(), params.print_stats);
+    trace_thread_name("main");
+
+    bool serve = !params.serve_socket.empty();
+    bool sharded = (params.shard_count > 1);
+
+    // 模型目录：--tessdata，其次TESSDATA_PREFIX，最后./config/tessdata
+    std::string tessdata_dir = params.tessdata_dir;
+    if (tessdata_dir.empty() && getenv("TESSDATA_PREFIX")) tessdata_dir = getenv("TESSDATA_PREFIX");
+    if (tessdata_dir.empty()) tessdata_dir = "config/tessdata";
+
+    // 报告版式
+    ReportLayout report_layout;
+    if (!params.font_path.empty()) report_layout.font_paths.push_back(params.font_path);
+    for (const auto& font : default_report_fonts(tessdata_dir)) report_layout.font_paths.push_back(font);
+    if (params.report_images == "full") {
+        report_layout.image_mode = REPORT_IMAGE_FULL;
+    } else if (params.report_images == "none") {
+        report_layout.image_mode = REPORT_IMAGE_NONE;
+    }
+
+    // 合并模式：汇总各分片的结果文件生成最终报告（不需要识别引擎）
+    if (params.merge) {
+        size_t result_num = 0;
+        if (!merge_shard_results(params.merge_inputs, params.pdf_output, report_layout, result_num)) {
+            std::cerr << "分片结果合并失败！" << std::endl;
+            return -1;
+        }
+        std::cout << "已合并" << params.merge_inputs.size() << "个分片，共" << result_num << "条结果" << std::endl;
+        std::cout << "PDF路径：" << params.pdf_output << std::endl;
+        return 0;
+    }
 
     // 2. 初始化OCR引擎
-    if (!init_ocr_engine("/home/he_yt/Multilingual_Recognition/code/Language_Recognition/config/tessdata")) {
+    if (!init_ocr_engine(tessdata_dir)) {
         std::cerr << "OCR引擎初始化失败！" << std::endl;
         return -1;
     }
 
-    // 3. 解析CSV文件
-    auto csv_data = parse_csv(params.csv_path);
-    if (csv_data.empty()) {
-        std::cerr << "CSV解析失败或无有效多语种数据！" << std::endl;
+    // 3. 建立图片目录索引（目录未变化时复用上次的索引缓存；服务模式下按作业的图片目录建立并常驻）
+    // 输出路径不含目录时使用当前目录（不能把报告文件名当作目录创建）
+    size_t slash = params.pdf_output.find_last_of("/");
+    std::string output_dir = ".";
+    if (!serve && slash != std::string::npos) output_dir = slash > 0 ? params.pdf_output.substr(0, slash) : "/";
+    ImageIndex img_index;
+    if (!serve) {
+        if (slash != std::string::npos && slash > 0) create_dir(output_dir);
+        if (!load_or_build_image_index(params.img_dir, output_dir + "/.image_index", img_index)) {
+            std::cerr << "图片目录索引建立失败！" << std::endl;
+            return -1;
+        }
+    }
+
+    // 每个工作线程持有各语种的常驻引擎，开启预加载时在线程启动阶段完成全部语种的模型加载
+    if (params.preload_engines) {
+        std::vector<std::string> lang_codes;
+        for (const auto& item : LANG_CODE_MAP) lang_codes.push_back(item.second);
+        set_engine_preload_langs(lang_codes);
+    }
+
+    // 语种关键词表（CSV解析时据此判断每条文言的语种）
+    if (!params.lang_keywords.empty()) {
+        std::vector<LangKeyword> keywords;
+        if (!load_lang_keywords(params.lang_keywords, keywords) || !set_lang_keywords(keywords)) {
+            return -1;
+        }
+    }
+
+    // 识别前图像预处理配置
+    PreprocessConfig preprocess_config;
+    preprocess_config.enabled = params.preprocess;
+    preprocess_config.invert = params.invert;
+    preprocess_config.deskew = params.deskew;
+    set_preprocess_config(preprocess_config);
+    set_ocr_cascade(params.cascade);
+
+    // ROI区域表（可从文件加载，也可在整页识别时学习）：未指定-R时使用输出目录regions.csv，
+    // 上次-L学习写出的区域表在下次运行时自动加载；学习模式下区域表尚不存在时从空表开始
+    std::string region_file = params.region_file;
+    if (region_file.empty() && !serve) region_file = output_dir + "/regions.csv";
+    RegionMap regions;
+    bool region_file_exists = !region_file.empty() && access(region_file.c_str(), F_OK) == 0;
+    if (region_file_exists) {
+        if (!load_region_map(region_file, regions)) return -1;
+        if (params.region_file.empty()) std::cout << "已加载区域表：" << region_file << std::endl;
+    } else if (!params.region_file.empty() && !params.learn_regions) {
+        std::cerr << "区域表不存在：" << params.region_file << std::endl;
         return -1;
     }
+    set_region_config(regions, params.learn_regions && !serve);
 
-    // 4. 按语种拆分任务
-    auto tasks = split_tasks_by_lang(
-        csv_data,
-        params.img_dir,
-        params.confidence,
-        params.pdf_output.substr(0, params.pdf_output.find_last_of("/"))
+    // 分片运行时清单与缓存按分片分开保存（同一目录下的多个分片进程互不干扰；
+    // 分片分配是确定的，同一分片下次运行处理的仍是这些记录）
+    std::string state_suffix = sharded ? ".shard-" + std::to_string(params.shard_index) + "-of-" + std::to_string(params.shard_count) : "";
+
+    // 识别结果缓存：图片内容、语种、设置与模型均未变化的记录直接复用上次识别结果
+    if (params.use_cache) {
+        std::string cache_dir = params.cache_dir.empty() ? output_dir + "/.ocr_cache" + state_suffix : params.cache_dir;
+        ocr_cache_open(cache_dir, params.cache_max_mb * 1024 * 1024);
+    }
+
+    // 4. 初始化线程池（默认每个CPU核一个识别线程；工作线程启动时预加载引擎、退出时释放）
+    int thread_count = params.threads > 0 ? params.threads : (int)std::thread::hardware_concurrency();
+    ThreadPool pool(
+        std::max(1, thread_count),
+        [](int) { warm_up_thread_engines(); },
+        [](int) { release_thread_engines(); }
     );
 
-    // 5. 初始化线程池并提交任务
-    if (!init_thread_pool(8)) {
-        std::cerr << "线程池初始化失败！" << std::endl;
-        return -1;
+    // 常驻服务模式：线程池与引擎在作业之间保持常驻，直到收到停止信号
+    if (serve) {
+        ServeConfig serve_config;
+        serve_config.socket_path = params.serve_socket;
+        serve_config.confidence = params.confidence;
+        serve_config.report_layout = report_layout;
+        serve_config.annotate = params.annotate;
+        serve_config.max_csv_bytes = params.serve_max_csv_mb * 1024 * 1024;
+        bool ok = run_job_server(serve_config, pool);
+        std::cout << "模型文件：共享映射" << mapped_model_count() << "个，共" << mapped_model_bytes() / (1024 * 1024)
+                  << "MB；已加载引擎" << get_engine_count() << "个" << std::endl;
+        pool.shutdown();
+        release_ocr_engine();
+        if (ocr_cache_enabled()) ocr_cache_close();
+        if (!params.trace_path.empty()) trace_write_chrome(params.trace_path);
+        if (params.print_stats) trace_print_stats(std::cout);
+        return ok ? 0 : -1;
+    }
+
+    // 5. 流式执行：CSV解析、图片查找、解码、识别与PDF生成同时进行
+    PipelineConfig pipeline_config;
+    pipeline_config.csv_path = params.csv_path;
+    pipeline_config.pdf_output = params.pdf_output;
+    pipeline_config.confidence = params.confidence;
+    pipeline_config.report_layout = report_layout;
+    if (params.annotate) pipeline_config.annotate.out_dir = output_dir + "/annotated";
+
+    // 分片模式：只处理本分片的记录，结果写入分片结果文件（-o），由合并模式生成最终报告
+    ShardResultWriter shard_writer;
+    if (sharded) {
+        pipeline_config.shard_index = params.shard_index;
+        pipeline_config.shard_count = params.shard_count;
+        pipeline_config.pdf_output.clear();
+        ShardSpec spec;
+        spec.index = params.shard_index;
+        spec.count = params.shard_count;
+        if (!shard_writer.open(params.pdf_output, spec)) return -1;
+        pipeline_config.on_result = [&shard_writer](const OcrResult& res) { shard_writer.add(res); };
+    }
+
+    // 运行清单：每次运行后写出，增量模式下据此跳过未变化的记录
+    std::string manifest_path = output_dir + "/.manifest" + state_suffix;
+    RunManifest prev_manifest, manifest;
+    if (params.incremental) {
+        if (load_run_manifest(manifest_path, prev_manifest)) {
+            pipeline_config.prev_manifest = &prev_manifest;
+            std::cout << "增量模式：上次运行清单共" << prev_manifest.rows.size() << "条记录" << std::endl;
+        } else {
+            std::cout << "增量模式：未找到上次运行清单，执行完整识别" << std::endl;
+        }
+    }
+    pipeline_config.manifest_out = &manifest;
+
+    // 结果日志：每条结果完成即追加，运行中断后可用--resume恢复；运行成功后删除
+    std::string journal_path = params.pdf_output + ".journal";
+    if (!params.resume && access(journal_path.c_str(), F_OK) == 0) {
+        std::cout << "发现上次未完成运行的结果日志，可使用--resume继续；本次重新识别：" << journal_path << std::endl;
+    }
+    ResultJournal journal;
+    if (journal.open(journal_path, params.resume)) {
+        pipeline_config.journal = &journal;
+        if (params.resume) {
+            // 日志中的记录比上次运行清单新，覆盖同一记录
+            for (const auto& item : journal.recovered().rows) prev_manifest.rows[item.first] = item.second;
+            pipeline_config.prev_manifest = &prev_manifest;
+            std::cout << "恢复运行：结果日志共" << journal.recovered().rows.size() << "条记录" << std::endl;
+        }
     }
-    submit_tasks(tasks);
 
-    // 6. 获取识别结果并生成PDF
-    auto all_results = get_all_results();
-    if (!generate_pdf(params.pdf_output, all_results)) {
-        std::cerr << "PDF生成失败！" << std::endl;
+    PipelineStats stats;
+    if (!run_pipeline(pipeline_config, img_index, pool, stats)) {
+        std::cerr << "识别流水线执行失败！" << std::endl;
+        journal.close(false);
+        return -1;
+    }
+    if (stats.rows == 0 && !sharded) {
+        std::cerr << "CSV解析失败或无有效多语种数据！" << std::endl;
+        journal.close(false);
         return -1;
     }
+    if (sharded && !shard_writer.close()) {
+        journal.close(false);
+        return -1;
+    }
+
+    save_run_manifest(manifest_path, manifest);
+    journal.close(true);
+
+    // 模型内存：每个语种的模型文件只映射一次，由各线程的引擎共用
+    std::cout << "模型文件：共享映射" << mapped_model_count() << "个，共" << mapped_model_bytes() / (1024 * 1024)
+              << "MB；已加载引擎" << get_engine_count() << "个，进程常驻内存" << process_rss_bytes() / (1024 * 1024) << "MB" << std::endl;
+
+    // 学习到的区域合并写回区域表
+    if (params.learn_regions) {
+        RegionMap learned = get_learned_regions();
+        for (const auto& item : learned) regions[item.first] = item.second;
+        if (save_region_map(region_file, regions)) {
+            std::cout << "已学习" << learned.size() << "个识别区域：" << region_file << std::endl;
+        }
+    }
 
-    // 7. 资源释放
+    // 6. 资源释放
+    pool.shutdown();
     release_ocr_engine();
-    destroy_thread_pool();
+    if (ocr_cache_enabled()) {
+        OcrCacheStats cache_stats = ocr_cache_stats();
+        std::cout << "识别结果缓存：命中" << cache_stats.hits << "条，未命中" << cache_stats.misses << "条" << std::endl;
+        ocr_cache_close();
+    }
 
     std::cout << "多语种识别任务完成！" << std::endl;
-    std::cout << "PDF路径：" << params.pdf_output << std::endl;
+    std::cout << "共处理" << stats.results << "条结果（未找到图片" << stats.missing_images << "条）" << std::endl;
+    if (params.incremental || params.resume) {
+        std::cout << (params.resume ? "恢复运行" : "增量模式") << "：复用" << stats.reused << "条，重新识别" << stats.results - stats.reused << "条" << std::endl;
+    }
+    if (sharded) {
+        std::cout << "分片" << params.shard_index << "/" << params.shard_count << "结果文件：" << params.pdf_output << std::endl;
+    } else {
+        std::cout << "PDF路径：" << params.pdf_output << std::endl;
+    }
+
+    // 各线程已停止，导出追踪文件与耗时统计
+    if (!params.trace_path.empty()) trace_write_chrome(params.trace_path);
+    if (params.print_stats) trace_print_stats(std::cout);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "annotator.h"
+#include "run_manifest.h"
+#include "hash_utils.h"
+#include <iostream>
+#include <algorithm>
+
+// 单词置信度低于该值时以橙色标出
+static const float LOW_WORD_CONFIDENCE = 0.6f;
+
+std::string annotated_image_path(const AnnotateConfig& config, const OcrResult& res) {
+    std::string stem = res.img_id.substr(0, res.img_id.find_last_of("."));
+    return config.out_dir + "/" + stem + "_" + hash_to_hex(hash_string(manifest_row_key(res))) + ".jpg";
+}
+
+static cv::Rect scaled_rect(int x, int y, int w, int h, double scale, const cv::Size& bounds) {
+    cv::Rect rect((int)(x * scale), (int)(y * scale), std::max(1, (int)(w * scale + 0.5)), std::max(1, (int)(h * scale + 0.5)));
+    return rect & cv::Rect(0, 0, bounds.width, bounds.height);
+}
+
+bool render_annotated_image(const cv::Mat& image, OcrResult& res, const AnnotateConfig& config) {
+    if (image.empty() || config.out_dir.empty()) return false;
+
+    // 先缩小再绘制，绘制与编码的开销随输出尺寸而非原图尺寸增长；原图缓冲区与识别、报告共用，不在原图上绘制
+    double scale = std::min(1.0, (double)config.max_side / std::max(image.cols, image.rows));
+    cv::Mat canvas;
+    if (scale < 1.0) {
+        cv::resize(image, canvas, cv::Size(), scale, scale, cv::INTER_AREA);
+    } else {
+        canvas = image.clone();
+    }
+
+    const cv::Scalar line_color(160, 160, 160);
+    const cv::Scalar word_color(255, 144, 30);
+    const cv::Scalar low_color(0, 165, 255);
+    const cv::Scalar match_color = res.is_ok ? cv::Scalar(0, 200, 0) : cv::Scalar(0, 0, 255);
+
+    bool any_matched = false;
+    for (const auto& box : res.text_boxes) {
+        cv::Rect rect = scaled_rect(box.x, box.y, box.w, box.h, scale, canvas.size());
+        if (rect.area() <= 0) continue;
+        if (box.level == OCR_BOX_LINE) {
+            cv::rectangle(canvas, rect, line_color, 1);
+        } else if (box.matched) {
+            // 匹配片段：半透明填充后加粗描边
+            cv::Mat area = canvas(rect);
+            cv::Mat fill(area.size(), area.type(), cv::Scalar(0, 255, 255));
+            cv::addWeighted(fill, 0.35, area, 0.65, 0, area);
+            cv::rectangle(canvas, rect, match_color, 2);
+            any_matched = true;
+        } else {
+            cv::rectangle(canvas, rect, box.confidence < LOW_WORD_CONFIDENCE ? low_color : word_color, 1);
+        }
+    }
+    // 未定位到匹配片段时框出识别区域
+    if (!any_matched && res.box.size() >= 4) {
+        cv::Rect rect = scaled_rect(res.box[0], res.box[1], res.box[2], res.box[3], scale, canvas.size());
+        if (rect.area() > 0) cv::rectangle(canvas, rect, match_color, 2);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s %.2f / %.2f", res.is_ok ? "OK" : "FAIL", res.match_score, res.confidence);
+    cv::putText(canvas, label, cv::Point(8, 24), cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(255, 255, 255), 3);
+    cv::putText(canvas, label, cv::Point(8, 24), cv::FONT_HERSHEY_SIMPLEX, 0.7, match_color, 1);
+
+    std::string path = annotated_image_path(config, res);
+    std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, config.jpeg_quality};
+    if (!cv::imwrite(path, canvas, params)) {
+        std::cerr << "标注图片写入失败：" << path << std::endl;
+        return false;
+    }
+    res.annotated_img = path;
+    return true;
+}
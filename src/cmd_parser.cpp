@@ -1,12 +1,64 @@
 #include "cmd_parser.h"
+#include "shard.h"
 #include <iostream>
-#include <unistd.h>
+#include <getopt.h>
+#include <cstring>
+
+// 仅有长格式的选项
+enum {
+    OPT_INCREMENTAL = 256,
+    OPT_LANG_KEYWORDS,
+    OPT_REPORT_IMAGES,
+    OPT_FONT,
+    OPT_TRACE,
+    OPT_STATS,
+    OPT_NO_CASCADE,
+    OPT_TESSDATA,
+    OPT_SERVE,
+    OPT_SHARD,
+    OPT_MERGE,
+    OPT_RESUME,
+    OPT_NO_ANNOTATE,
+    OPT_MAX_CSV_MB
+};
+
+static const struct option LONG_OPTIONS[] = {
+    {"csv", required_argument, nullptr, 'c'},
+    {"images", required_argument, nullptr, 'i'},
+    {"output", required_argument, nullptr, 'o'},
+    {"threshold", required_argument, nullptr, 't'},
+    {"threads", required_argument, nullptr, 'j'},
+    {"preload", no_argument, nullptr, 'p'},
+    {"no-preprocess", no_argument, nullptr, 'n'},
+    {"deskew", no_argument, nullptr, 'k'},
+    {"invert", required_argument, nullptr, 'I'},
+    {"regions", required_argument, nullptr, 'R'},
+    {"learn-regions", no_argument, nullptr, 'L'},
+    {"cache-dir", required_argument, nullptr, 'C'},
+    {"no-cache", no_argument, nullptr, 'x'},
+    {"cache-max-mb", required_argument, nullptr, 'M'},
+    {"incremental", no_argument, nullptr, OPT_INCREMENTAL},
+    {"lang-keywords", required_argument, nullptr, OPT_LANG_KEYWORDS},
+    {"report-images", required_argument, nullptr, OPT_REPORT_IMAGES},
+    {"font", required_argument, nullptr, OPT_FONT},
+    {"trace", required_argument, nullptr, OPT_TRACE},
+    {"stats", no_argument, nullptr, OPT_STATS},
+    {"no-cascade", no_argument, nullptr, OPT_NO_CASCADE},
+    {"tessdata", required_argument, nullptr, OPT_TESSDATA},
+    {"serve", required_argument, nullptr, OPT_SERVE},
+    {"shard", required_argument, nullptr, OPT_SHARD},
+    {"merge", no_argument, nullptr, OPT_MERGE},
+    {"resume", no_argument, nullptr, OPT_RESUME},
+    {"no-annotate", no_argument, nullptr, OPT_NO_ANNOTATE},
+    {"max-csv-mb", required_argument, nullptr, OPT_MAX_CSV_MB},
+    {nullptr, 0, nullptr, 0}
+};
 
 CmdParams parse_cmd_args(int argc, char** argv) {
     CmdParams params;
     int opt;
 
-    while ((opt = getopt(argc, argv, "c:i:o:t:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:i:o:t:j:pnkI:R:LC:xM:", LONG_OPTIONS, nullptr)) != -1) {
         switch (opt) {
             case 'c':
                 params.csv_path = optarg;
@@ -20,21 +72,152 @@ CmdParams parse_cmd_args(int argc, char** argv) {
             case 't':
                 params.confidence = atof(optarg);
                 break;
+            case 'j':
+                params.threads = atoi(optarg);
+                if (params.threads <= 0) {
+                    std::cerr << "识别线程数应为正整数：" << optarg << std::endl;
+                    params.is_valid = false;
+                    return params;
+                }
+                break;
+            case 'p':
+                params.preload_engines = true;
+                break;
+            case 'n':
+                params.preprocess = false;
+                break;
+            case 'k':
+                params.deskew = true;
+                break;
+            case 'R':
+                params.region_file = optarg;
+                break;
+            case 'L':
+                params.learn_regions = true;
+                break;
+            case 'C':
+                params.cache_dir = optarg;
+                break;
+            case 'x':
+                params.use_cache = false;
+                break;
+            case 'M':
+                params.cache_max_mb = (size_t)atol(optarg);
+                break;
+            case OPT_INCREMENTAL:
+                params.incremental = true;
+                break;
+            case OPT_RESUME:
+                params.resume = true;
+                break;
+            case OPT_NO_ANNOTATE:
+                params.annotate = false;
+                break;
+            case OPT_LANG_KEYWORDS:
+                params.lang_keywords = optarg;
+                break;
+            case OPT_REPORT_IMAGES:
+                if (strcmp(optarg, "thumb") != 0 && strcmp(optarg, "full") != 0 && strcmp(optarg, "none") != 0) {
+                    params.is_valid = false;
+                    return params;
+                }
+                params.report_images = optarg;
+                break;
+            case OPT_FONT:
+                params.font_path = optarg;
+                break;
+            case OPT_TRACE:
+                params.trace_path = optarg;
+                break;
+            case OPT_STATS:
+                params.print_stats = true;
+                break;
+            case OPT_NO_CASCADE:
+                params.cascade = false;
+                break;
+            case OPT_TESSDATA:
+                params.tessdata_dir = optarg;
+                break;
+            case OPT_SERVE:
+                params.serve_socket = optarg;
+                break;
+            case OPT_MAX_CSV_MB:
+                params.serve_max_csv_mb = (size_t)atol(optarg);
+                break;
+            case OPT_SHARD: {
+                ShardSpec spec;
+                if (!parse_shard_spec(optarg, spec)) {
+                    std::cerr << "分片格式错误（应为i/N，0<=i<N）：" << optarg << std::endl;
+                    params.is_valid = false;
+                    return params;
+                }
+                params.shard_index = spec.index;
+                params.shard_count = spec.count;
+                break;
+            }
+            case OPT_MERGE:
+                params.merge = true;
+                break;
+            case 'I':
+                if (strcmp(optarg, "on") == 0) {
+                    params.invert = 1;
+                } else if (strcmp(optarg, "off") == 0) {
+                    params.invert = 0;
+                } else {
+                    params.invert = -1;
+                }
+                break;
             default:
                 params.is_valid = false;
                 return params;
         }
     }
 
-    // 校验必填参数
-    params.is_valid = !(params.csv_path.empty() || params.img_dir.empty() || params.pdf_output.empty());
+    // 合并模式：其余参数为各分片的结果文件
+    if (params.merge) {
+        for (int i = optind; i < argc; i++) params.merge_inputs.push_back(argv[i]);
+        params.is_valid = !params.pdf_output.empty() && !params.merge_inputs.empty();
+        return params;
+    }
+
+    // 校验必填参数（服务模式由各作业指定CSV、图片目录与输出）
+    params.is_valid = !params.serve_socket.empty() ||
+                      !(params.csv_path.empty() || params.img_dir.empty() || params.pdf_output.empty());
     return params;
 }
 
 void print_usage() {
-    std::cout << "用法：./text_matcher -c <CSV路径> -i <图片目录> -o <PDF输出路径> [-t <置信度>]" << std::endl;
+    std::cout << "用法：./text_matcher -c <CSV路径> -i <图片目录> -o <PDF输出路径> [-t <置信度>] [-j <线程数>] [-p] [-n] [-k] [-I <auto|on|off>] [-R <区域表>] [-L] [-C <缓存目录>] [-x] [-M <MB>] [--incremental] [--resume] [--lang-keywords <关键词表>] [--report-images <thumb|full|none>] [--font <TTF字体>] [--no-cascade] [--no-annotate] [--tessdata <模型目录>] [--trace <追踪文件>] [--stats]" << std::endl;
+    std::cout << "      ./text_matcher --shard <i/N> -c <CSV路径> -i <图片目录> -o <分片结果文件> [识别选项]" << std::endl;
+    std::cout << "      ./text_matcher --merge -o <PDF输出路径> <分片结果文件...>" << std::endl;
+    std::cout << "      ./text_matcher --serve <套接字路径> [--max-csv-mb <MB>] [--tessdata <模型目录>] [-t <置信度>] [其他识别选项]" << std::endl;
     std::cout << "  -c: 文言库CSV文件路径（必填，格式：序号,,模块,描述,元信息,确认文言表示,目标文言,Y,Y,Y）" << std::endl;
     std::cout << "  -i: 待识别图片目录（必填，图片命名：StringID+扩展.png）" << std::endl;
     std::cout << "  -o: PDF输出路径（必填，如：./output/result.pdf）" << std::endl;
     std::cout << "  -t: 识别置信度阈值（可选，默认0.8）" << std::endl;
+    std::cout << "  -j: 识别线程数（可选，默认为CPU核数）" << std::endl;
+    std::cout << "  -p: 工作线程启动时预加载全部语种引擎（可选，默认按需加载）" << std::endl;
+    std::cout << "  -n: 关闭识别前图像预处理（灰度化/二值化/缩放，默认开启）" << std::endl;
+    std::cout << "  -k: 开启倾斜校正（可选）" << std::endl;
+    std::cout << "  -I: 深色主题反色处理（auto/on/off，默认auto）" << std::endl;
+    std::cout << "  -R: ROI区域表文件（可选，每行：ScreenID/PartID,x,y,w,h），命中的记录只识别该区域；未指定时自动加载输出目录regions.csv（存在时）" << std::endl;
+    std::cout << "  -L: 从整页识别结果学习区域并写回区域表（未指定-R时写入输出目录regions.csv，下次运行自动加载；区域表不存在时新建）" << std::endl;
+    std::cout << "  -C: 识别结果缓存目录（可选，默认：输出目录/.ocr_cache）" << std::endl;
+    std::cout << "  -x: 不使用识别结果缓存" << std::endl;
+    std::cout << "  -M: 识别结果缓存上限（MB，默认1024）" << std::endl;
+    std::cout << "  --incremental: 增量模式，与上次运行清单（输出目录/.manifest）比对，只识别文言、元数据或图片有变化的记录，其余沿用上次结果" << std::endl;
+    std::cout << "  --resume: 从结果日志（<PDF输出路径>.journal，运行中每条结果完成即追加）恢复中断的运行，已记录且未变化的记录不再识别，报告按日志与新结果重新生成" << std::endl;
+    std::cout << "  --lang-keywords: 语种关键词表（每行：语种,关键词；忽略大小写；靠前的语种优先），默认使用内置表" << std::endl;
+    std::cout << "  --report-images: 报告图片嵌入方式（thumb：缩略图，FAIL记录的原图附在末尾，默认；full：原图；none：仅表格），同一图片只嵌入一次" << std::endl;
+    std::cout << "  --font: 报告字体（TrueType），优先于模型目录pdf.ttf与系统Unicode字体；每段文本使用第一个能完整显示它的字体" << std::endl;
+    std::cout << "  --no-cascade: 关闭两级识别（默认对模型目录fast/下有同名快速模型的语种及命中识别区域的记录先用快速配置识别：快速模型、关闭词典、整页时按稀疏文本识别；置信度或文言相似度低于-t的再用精确配置重新识别；其余记录直接按精确配置识别）" << std::endl;
+    std::cout << "  --no-annotate: 不生成标注图片（默认在输出目录/annotated下为每条记录生成标注图片：文本行与单词识别框，与期望文言匹配的片段高亮；报告仍嵌入原图，各行识别位置以矢量框叠加）" << std::endl;
+    std::cout << "  --tessdata: Tesseract模型目录（默认：环境变量TESSDATA_PREFIX，其次./config/tessdata）" << std::endl;
+    std::cout << "  --serve: 常驻服务模式，引擎与图片索引常驻，通过Unix域套接字接收作业（csv <路径>|csv_data <字节数>、images <目录>、[output <PDF>]、[threshold <值>]、end），逐条返回识别结果；多个作业同时运行时平分识别线程" << std::endl;
+    std::cout << "  --max-csv-mb: 服务模式下作业以csv_data直接发送的CSV内容上限（MB，默认64），超出时返回ERROR" << std::endl;
+    std::cout << "  --shard: 只处理第i片记录（共N片，按String ID+语种的稳定哈希分配），-o为分片结果文件；各片可在不同机器或本机多个进程运行" << std::endl;
+    std::cout << "  --merge: 合并全部N个分片结果文件，按CSV行号排序、重新统计全局出现次数并生成最终PDF" << std::endl;
+    std::cout << "  --trace: 记录各线程的阶段耗时（查找、解码、引擎加载/切换、识别、比对、报告写入）与队列深度，结束时写出Chrome/Perfetto追踪文件（JSON）" << std::endl;
+    std::cout << "  --stats: 结束时打印分阶段、分语种的耗时分布（P50/P90/P99）、各线程忙碌/空闲时间与队列深度" << std::endl;
+    std::cout << "  各选项另有长格式：--csv --images --output --threshold --threads --preload --no-preprocess --deskew --invert --regions --learn-regions --cache-dir --no-cache --cache-max-mb" << std::endl;
 }
\ No newline at end of file
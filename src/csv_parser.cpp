@@ -1,147 +1,249 @@
 #include "csv_parser.h"
 #include "csv_utils.h"  // 引入抽离的工具函数
-#include <fstream>
+#include "lang_detect.h"
 #include <sstream>
 #include <stdexcept>
 #include <unistd.h>
-#include <regex>
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <future>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+// 元数据字段中的键，键后为全角或半角冒号，值取到行尾
+static const std::string_view META_KEYS[] = {"ScreenID", "PartID", "String ID"};
+
+static std::string_view trim_view(std::string_view text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) return std::string_view();
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// 逐行扫描一遍元数据块，提取ScreenID/PartID/String ID（各取首次出现）
+static void parse_meta_block(std::string_view block, CsvMeta& meta) {
+    std::string_view values[3];
+    size_t line_begin = 0;
+    while (line_begin <= block.size()) {
+        size_t line_end = block.find('\n', line_begin);
+        if (line_end == std::string_view::npos) line_end = block.size();
+        std::string_view line = block.substr(line_begin, line_end - line_begin);
+        line_begin = line_end + 1;
+
+        for (int k = 0; k < 3; k++) {
+            if (!values[k].empty()) continue;
+            size_t pos = line.find(META_KEYS[k]);
+            if (pos == std::string_view::npos) continue;
+            std::string_view rest = line.substr(pos + META_KEYS[k].size());
+            if (rest.compare(0, 3, "：") == 0) {
+                rest.remove_prefix(3);
+            } else if (!rest.empty() && rest[0] == ':') {
+                rest.remove_prefix(1);
+            } else {
+                continue;
+            }
+            values[k] = trim_view(rest);
+            if (!values[k].empty()) break;
+        }
+    }
+    // ScreenID/PartID在多行间重复，驻留；String ID基本每行唯一，保留为普通字符串
+    if (!values[0].empty()) meta.screen_id = values[0];
+    if (!values[1].empty()) meta.part_id = values[1];
+    if (!values[2].empty()) meta.string_id = std::string(values[2]);
+}
+
+// 重复字段直接按原始内容驻留，不含转义引号时不产生临时字符串
+static InternedString intern_csv_field(const CsvField& field) {
+    return field.has_quotes ? InternedString(csv_field_string(field)) : InternedString(field.text);
+}
 
 // 仅保留非inline函数的实现
-CsvMeta extract_csv_meta(const std::vector<std::string>& fields, const std::string& original_line, int line_num) {
+CsvMeta extract_csv_meta(const std::vector<CsvField>& fields, std::string_view record, int line_num, std::ostream& log) {
     CsvMeta meta;
     meta.line_num = line_num;
-    meta.seq_id = fields[0];
-    
-    if (fields.size() >= 3) meta.module = fields[2];
-    if (fields.size() >= 4) meta.desc = fields[3];
-    
-    meta.lang_text = extract_target_text(original_line);
+
+    // 先判断目标文言，未通过的记录不再拷贝其余字段
+    meta.lang_text = extract_target_text(record);
     if (meta.lang_text.empty()) {
-        std::cerr << "CSV第" << line_num << "行：未提取到目标文言内容，跳过！" << std::endl;
+        log << "CSV第" << line_num << "行：未提取到目标文言内容，跳过！" << std::endl;
         return meta;
     }
 
-    if (fields.size() >= 5 && !fields[4].empty()) {
-        std::string meta_str = fields[4];
-        std::regex screen_regex(R"(ScreenID：(.+)\n)");
-        std::smatch screen_match;
-        if (std::regex_search(meta_str, screen_match, screen_regex)) {
-            meta.screen_id = screen_match.str(1);
-        }
+    meta.seq_id = csv_field_string(fields[0]);
+    if (fields.size() >= 3) meta.module = intern_csv_field(fields[2]);
+    if (fields.size() >= 4) meta.desc = csv_field_string(fields[3]);
 
-        std::regex part_regex(R"(PartID:(.+)\n)");
-        std::smatch part_match;
-        if (std::regex_search(meta_str, part_match, part_regex)) {
-            meta.part_id = part_match.str(1);
-        }
-
-        std::regex string_regex(R"(String ID:(.+))");
-        std::smatch string_match;
-        if (std::regex_search(meta_str, string_match, string_regex)) {
-            meta.string_id = string_match.str(1);
+    if (fields.size() >= 5 && !fields[4].text.empty()) {
+        if (fields[4].has_quotes) {
+            parse_meta_block(csv_field_string(fields[4]), meta);
+        } else {
+            parse_meta_block(fields[4].text, meta);
         }
     }
 
-    std::string lower_text = meta.lang_text;
-    std::transform(lower_text.begin(), lower_text.end(), lower_text.begin(), ::tolower);
-    
-    if (lower_text.find("Englist") != std::string::npos || lower_text.find("uk") != std::string::npos || lower_text.find("englist") != std::string::npos) {
-        meta.lang = "英语";
-    } else if (lower_text.find("French") != std::string::npos || lower_text.find("french") != std::string::npos) {
-        meta.lang = "法语";
-    } else if (lower_text.find("deutsch") != std::string::npos || lower_text.find("german") != std::string::npos) {
-        meta.lang = "德语";
-    } else if (lower_text.find("русский") != std::string::npos || lower_text.find("russian") != std::string::npos) {
-        meta.lang = "俄语";
-    } else if (lower_text.find("español") != std::string::npos || lower_text.find("spanish") != std::string::npos) {
-        meta.lang = "西班牙语";
-    } else if (lower_text.find("português") != std::string::npos || lower_text.find("portuguese") != std::string::npos) {
-        meta.lang = "葡萄牙语";
-    } else if (lower_text.find("italiano") != std::string::npos || lower_text.find("italian") != std::string::npos) {
-        meta.lang = "意大利语";
-    } else if (lower_text.find("türkçe") != std::string::npos || lower_text.find("turkish") != std::string::npos) {
-        meta.lang = "土耳其语";
-    } else if (lower_text.find("ไทย") != std::string::npos || lower_text.find("thai") != std::string::npos) {
-        meta.lang = "泰语";
-    } else if (lower_text.find("العربية") != std::string::npos || lower_text.find("arabic") != std::string::npos) {
-        meta.lang = "阿拉伯语";
-    } else {
-        meta.lang = "英语";
+    meta.lang = detect_lang(meta.lang_text);
+    meta.lang_id = lang_id_of(meta.lang);
+    if (!meta.lang.empty() && meta.lang_id == LANG_UNKNOWN) {
+        // 关键词表中有、但没有对应识别模型编码的语种，不按英文模型识别
+        log << "CSV第" << line_num << "行：语种[" << meta.lang << "]没有对应的模型编码，跳过！" << std::endl;
+        meta.lang = InternedString();
     }
-
     return meta;
 }
 
-std::map<std::string, std::vector<CsvMeta>> parse_csv(const std::string& csv_path) {
-    std::map<std::string, std::vector<CsvMeta>> csv_data;
-
-    if (access(csv_path.c_str(), F_OK) != 0) {
-        throw std::runtime_error("CSV文件不存在：" + csv_path);
-    }
-
-    std::ifstream csv_file(csv_path, std::ios::in | std::ios::binary);
-    if (!csv_file) {
-        throw std::runtime_error("无法打开CSV文件：" + csv_path);
+// 单线程解析的最小分块大小，小文件不拆分
+static const size_t CSV_MIN_CHUNK_SIZE = 1 << 20;
+
+// 文件分块：第一遍统计引号与换行数，据此推算各块起点处的引号状态与行号
+struct CsvChunk {
+    size_t begin = 0;
+    size_t end = 0;
+    size_t quotes = 0;
+    size_t lines = 0;
+};
+
+// 一个分块的解析结果（按块顺序回调，告警也按行序输出）
+struct CsvChunkResult {
+    std::vector<CsvMeta> rows;
+    std::string log;
+};
+
+// 从pos开始（引号状态in_quote）找到下一条记录的起点：引号外换行符的下一个字节
+static size_t next_record_start(std::string_view data, size_t pos, bool in_quote, size_t& lines) {
+    for (; pos < data.size(); pos++) {
+        char c = data[pos];
+        if (c == '"') {
+            in_quote = !in_quote;
+        } else if (c == '\n') {
+            lines++;
+            if (!in_quote) return pos + 1;
+        }
     }
+    return data.size();
+}
 
-    std::string line;
-    int line_num = 0;
-    while (std::getline(csv_file, line)) {
-        line_num++;
-        if (line.empty()) continue;
-
-        std::string original_line = line;
-        std::vector<std::string> fields = parse_csv_line(line);
+// 解析[begin, end)内的完整记录，first_line为begin所在行号
+static void parse_csv_range(std::string_view data, size_t begin, size_t end, int first_line, CsvChunkResult& out) {
+    std::ostringstream log;
+    std::vector<CsvField> fields;
+    int line_num = first_line;
+    size_t pos = begin;
+    while (pos < end) {
+        size_t lines = 0;
+        size_t next = next_record_start(data, pos, false, lines);
+        std::string_view record = data.substr(pos, next - pos);
+        if (!record.empty() && record.back() == '\n') record.remove_suffix(1);
+        if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+
+        int record_line = line_num;
+        line_num += (int)std::max<size_t>(lines, 1);
+        pos = next;
+        if (record.empty()) continue;
+
+        split_csv_record(record, fields);
         if (fields.size() < 8) {
-            std::cerr << "CSV第" << line_num << "行格式错误（字段数不足），跳过！" << std::endl;
+            log << "CSV第" << record_line << "行格式错误（字段数不足），跳过！" << std::endl;
             continue;
         }
 
-        CsvMeta meta = extract_csv_meta(fields, original_line, line_num);
+        CsvMeta meta = extract_csv_meta(fields, record, record_line, log);
         if (meta.lang.empty() || meta.string_id.empty() || meta.lang_text.empty()) {
             continue;
         }
-
-        csv_data[meta.lang].push_back(meta);
+        out.rows.push_back(std::move(meta));
     }
-
-    csv_file.close();
-    return csv_data;
+    out.log = log.str();
 }
 
-std::vector<LangTask> split_tasks_by_lang(
-    const std::map<std::string, std::vector<CsvMeta>>& csv_data,
-    const std::string& img_dir,
-    double confidence,
-    const std::string& output_dir
-) {
-    std::vector<LangTask> tasks;
-
-    for (const auto& [lang, meta_list] : csv_data) {
-        LangTask task;
-        task.lang = lang;
-        auto lang_it = LANG_CODE_MAP.find(lang);
-        task.lang_code = (lang_it != LANG_CODE_MAP.end()) ? lang_it->second : "eng";
-        task.confidence_threshold = confidence;
-        task.output_dir = output_dir + "/" + lang;
-
-        for (const auto& meta : meta_list) {
-            if (meta.string_id.empty()) continue;
-            std::string img_path = match_image_by_string_id(img_dir, meta.string_id);
-            if (img_path.empty()) {
-                std::cerr << "未找到String ID[" << meta.string_id << "]对应的图片，跳过！" << std::endl;
-                continue;
-            }
-            task.img_meta_list.emplace_back(img_path, meta);
+int parse_csv_data(std::string_view data, const std::function<void(CsvMeta&)>& on_row) {
+    if (data.empty()) return 0;
+
+    // 按大小切分，每块一个线程
+    size_t chunk_num = std::max<size_t>(1, std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                            data.size() / CSV_MIN_CHUNK_SIZE));
+    std::vector<CsvChunk> chunks(chunk_num);
+    for (size_t i = 0; i < chunk_num; i++) {
+        chunks[i].begin = data.size() * i / chunk_num;
+        chunks[i].end = data.size() * (i + 1) / chunk_num;
+    }
+
+    // 第一遍：各块并行统计引号与换行数
+    auto count_chunk = [&data](CsvChunk& chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; i++) {
+            if (data[i] == '"') chunk.quotes++;
+            else if (data[i] == '\n') chunk.lines++;
         }
+    };
+    if (chunk_num > 1) {
+        std::vector<std::thread> counters;
+        for (auto& chunk : chunks) counters.emplace_back(count_chunk, std::ref(chunk));
+        for (auto& counter : counters) counter.join();
+    }
+
+    // 第二遍：各块从块内第一条完整记录开始解析，到下一块的第一条完整记录为止
+    std::vector<size_t> starts(chunk_num + 1, data.size());
+    std::vector<int> start_lines(chunk_num + 1, 0);
+    starts[0] = 0;
+    start_lines[0] = 1;
+    size_t quotes = 0, lines = 0;
+    for (size_t i = 1; i < chunk_num; i++) {
+        quotes += chunks[i - 1].quotes;
+        lines += chunks[i - 1].lines;
+        size_t skipped = 0;
+        starts[i] = next_record_start(data, chunks[i].begin, quotes % 2 == 1, skipped);
+        start_lines[i] = (int)(lines + skipped) + 1;
+        if (starts[i] < starts[i - 1]) starts[i] = starts[i - 1];
+    }
+
+    std::vector<std::future<CsvChunkResult>> parts;
+    for (size_t i = 0; i < chunk_num; i++) {
+        auto parse_part = [&data, &starts, &start_lines, i]() {
+            CsvChunkResult result;
+            parse_csv_range(data, starts[i], std::max(starts[i], starts[i + 1]), start_lines[i], result);
+            return result;
+        };
+        parts.push_back(std::async(chunk_num > 1 ? std::launch::async : std::launch::deferred, parse_part));
+    }
 
-        if (!task.img_meta_list.empty()) {
-            tasks.push_back(task);
+    // 按块顺序回调，保持与文件相同的记录顺序
+    int row_count = 0;
+    for (auto& part : parts) {
+        CsvChunkResult result = part.get();
+        std::cerr << result.log;
+        for (auto& meta : result.rows) {
+            on_row(meta);
+            row_count++;
         }
     }
+    return row_count;
+}
+
+int parse_csv_rows(const std::string& csv_path, const std::function<void(CsvMeta&)>& on_row) {
+    if (access(csv_path.c_str(), F_OK) != 0) {
+        throw std::runtime_error("CSV文件不存在：" + csv_path);
+    }
 
-    return tasks;
+    int fd = open(csv_path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("无法打开CSV文件：" + csv_path);
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("无法映射CSV文件：" + csv_path);
+    }
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+    int row_count = parse_csv_data(std::string_view((const char*)mapped, (size_t)st.st_size), on_row);
+    munmap(mapped, st.st_size);
+    return row_count;
 }
\ No newline at end of file
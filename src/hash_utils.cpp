@@ -0,0 +1,36 @@
+#include "hash_utils.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+bool hash_file(const std::string& path, uint64_t& hash) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        hash = hash_bytes("", 0);
+        return true;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    hash = hash_bytes(data, st.st_size);
+    munmap(data, st.st_size);
+    return true;
+}
+
+std::string hash_to_hex(uint64_t hash) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+    return buf;
+}
@@ -0,0 +1,221 @@
+#include "image_index.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <cstring>
+
+// 单个扫描线程的结果（dir_idx为线程内局部下标，合并时再偏移）
+struct ScanPart {
+    std::vector<ImageDirStamp> dirs;
+    std::vector<ImageEntry> entries;
+};
+
+static bool stat_dir(const std::string& path, ImageDirStamp& stamp) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) return false;
+    stamp.path = path;
+    stamp.mtime_sec = st.st_mtim.tv_sec;
+    stamp.mtime_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
+
+// 列出目录一层内容（与find默认行为一致：不进入符号链接目录，符号链接本身按文件处理）
+static bool list_dir(const std::string& path, std::vector<std::string>& files, std::vector<std::string>& sub_dirs) {
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        std::cerr << "无法打开图片目录：" << path << std::endl;
+        return false;
+    }
+
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        const char* name = ent->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        bool is_dir = (ent->d_type == DT_DIR);
+        if (ent->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = (lstat((path + "/" + name).c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+        }
+
+        if (is_dir) {
+            sub_dirs.push_back(path + "/" + name);
+        } else {
+            files.push_back(name);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+// 递归扫描目录
+static void scan_dir(const std::string& path, ScanPart& part) {
+    ImageDirStamp stamp;
+    if (!stat_dir(path, stamp)) return;
+    unsigned int dir_idx = part.dirs.size();
+    part.dirs.push_back(stamp);
+
+    std::vector<std::string> files, sub_dirs;
+    list_dir(path, files, sub_dirs);
+    for (auto& name : files) {
+        part.entries.push_back({std::move(name), dir_idx});
+    }
+    for (const auto& sub_dir : sub_dirs) {
+        scan_dir(sub_dir, part);
+    }
+}
+
+bool build_image_index(const std::string& img_dir, ImageIndex& index) {
+    index = ImageIndex();
+    index.root = img_dir;
+    while (index.root.size() > 1 && index.root.back() == '/') index.root.pop_back();
+
+    ImageDirStamp root_stamp;
+    if (!stat_dir(index.root, root_stamp)) {
+        std::cerr << "图片目录不存在：" << img_dir << std::endl;
+        return false;
+    }
+
+    // 先扫描根目录本层，顶层子目录交给多个线程并行扫描
+    ScanPart root_part;
+    root_part.dirs.push_back(root_stamp);
+    std::vector<std::string> root_files, top_dirs;
+    if (!list_dir(index.root, root_files, top_dirs)) return false;
+    for (auto& name : root_files) {
+        root_part.entries.push_back({std::move(name), 0});
+    }
+
+    int thread_num = std::max(1, std::min((int)top_dirs.size(), (int)std::thread::hardware_concurrency()));
+    std::vector<ScanPart> parts(thread_num);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < thread_num; t++) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = t; i < top_dirs.size(); i += thread_num) {
+                scan_dir(top_dirs[i], parts[t]);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // 合并各线程结果，修正目录下标
+    parts.insert(parts.begin(), std::move(root_part));
+    for (auto& part : parts) {
+        unsigned int offset = index.dirs.size();
+        for (auto& stamp : part.dirs) index.dirs.push_back(std::move(stamp));
+        for (auto& entry : part.entries) {
+            entry.dir_idx += offset;
+            index.entries.push_back(std::move(entry));
+        }
+    }
+
+    // 按文件名排序（同名按目录路径），保证查找结果确定
+    std::sort(index.entries.begin(), index.entries.end(), [&index](const ImageEntry& a, const ImageEntry& b) {
+        if (a.name != b.name) return a.name < b.name;
+        return index.dirs[a.dir_idx].path < index.dirs[b.dir_idx].path;
+    });
+
+    std::cout << "图片索引建立完成：" << index.entries.size() << "个文件，" << index.dirs.size() << "个目录" << std::endl;
+    return true;
+}
+
+// 缓存格式（文本）：
+//   IMGIDX1\t<根目录>
+//   D\t<mtime秒>\t<mtime纳秒>\t<目录路径>
+//   F\t<目录下标>\t<文件名>
+bool save_image_index(const ImageIndex& index, const std::string& cache_path) {
+    // 临时文件名带进程号：同一输出目录下的多个分片进程可能同时写回
+    std::string tmp_path = cache_path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(tmp_path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        std::cerr << "无法写入图片索引缓存：" << cache_path << std::endl;
+        return false;
+    }
+    out << "IMGIDX1\t" << index.root << "\n";
+    for (const auto& stamp : index.dirs) {
+        out << "D\t" << stamp.mtime_sec << "\t" << stamp.mtime_nsec << "\t" << stamp.path << "\n";
+    }
+    for (const auto& entry : index.entries) {
+        out << "F\t" << entry.dir_idx << "\t" << entry.name << "\n";
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        std::cerr << "图片索引缓存保存失败：" << cache_path << std::endl;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool load_image_index(const std::string& cache_path, ImageIndex& index) {
+    std::ifstream in(cache_path, std::ios::in);
+    if (!in) return false;
+
+    index = ImageIndex();
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, 8, "IMGIDX1\t") != 0) return false;
+    index.root = line.substr(8);
+
+    while (std::getline(in, line)) {
+        if (line.size() < 2) continue;
+        size_t p1 = line.find('\t', 2);
+        if (p1 == std::string::npos) return false;
+        if (line[0] == 'D') {
+            size_t p2 = line.find('\t', p1 + 1);
+            if (p2 == std::string::npos) return false;
+            ImageDirStamp stamp;
+            stamp.mtime_sec = atol(line.substr(2, p1 - 2).c_str());
+            stamp.mtime_nsec = atol(line.substr(p1 + 1, p2 - p1 - 1).c_str());
+            stamp.path = line.substr(p2 + 1);
+            index.dirs.push_back(stamp);
+        } else if (line[0] == 'F') {
+            unsigned int dir_idx = (unsigned int)atol(line.substr(2, p1 - 2).c_str());
+            if (dir_idx >= index.dirs.size()) return false;
+            index.entries.push_back({line.substr(p1 + 1), dir_idx});
+        }
+    }
+    return true;
+}
+
+// 目录的修改时间未变 => 目录内文件列表未变
+bool image_index_is_fresh(const ImageIndex& index) {
+    for (const auto& stamp : index.dirs) {
+        ImageDirStamp now;
+        if (!stat_dir(stamp.path, now)) return false;
+        if (now.mtime_sec != stamp.mtime_sec || now.mtime_nsec != stamp.mtime_nsec) return false;
+    }
+    return !index.dirs.empty();
+}
+
+bool load_or_build_image_index(const std::string& img_dir, const std::string& cache_path, ImageIndex& index) {
+    std::string root = img_dir;
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+
+    if (!cache_path.empty() && load_image_index(cache_path, index) && index.root == root && image_index_is_fresh(index)) {
+        std::cout << "复用图片索引缓存：" << cache_path << "（" << index.entries.size() << "个文件）" << std::endl;
+        return true;
+    }
+
+    if (!build_image_index(img_dir, index)) return false;
+    if (!cache_path.empty()) save_image_index(index, cache_path);
+    return true;
+}
+
+std::string match_image_by_string_id(const ImageIndex& index, const std::string& string_id) {
+    if (string_id.empty()) return "";
+
+    // 以String ID为前缀的文件名在排序后连续排列
+    auto it = std::lower_bound(index.entries.begin(), index.entries.end(), string_id,
+        [](const ImageEntry& entry, const std::string& key) { return entry.name < key; });
+    for (; it != index.entries.end(); ++it) {
+        if (it->name.compare(0, string_id.size(), string_id) != 0) break;
+        const std::string& name = it->name;
+        if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".png") == 0) {
+            return index.dirs[it->dir_idx].path + "/" + name;
+        }
+    }
+    return "";
+}
@@ -0,0 +1,323 @@
+#include "job_server.h"
+#include "pipeline.h"
+#include "image_index.h"
+#include "run_manifest.h"
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_serve_stop = 0;
+
+static void on_stop_signal(int) {
+    g_serve_stop = 1;
+}
+
+// 单个作业的请求内容
+struct JobRequest {
+    std::string csv_path;
+    std::string csv_text;
+    std::string img_dir;
+    std::string pdf_output;
+    double confidence = 0;
+};
+
+// 按目录缓存的图片索引：目录未变化时各作业直接复用，变化后重新扫描
+class ImageIndexCache {
+public:
+    std::shared_ptr<const ImageIndex> get(const std::string& img_dir) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_indexes.find(img_dir);
+            if (it != m_indexes.end() && image_index_is_fresh(*it->second)) return it->second;
+        }
+        // 扫描不持锁，避免阻塞其他目录的作业
+        std::shared_ptr<ImageIndex> index(new ImageIndex());
+        if (!build_image_index(img_dir, *index)) return nullptr;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_indexes[img_dir] = index;
+        return index;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<std::string, std::shared_ptr<const ImageIndex>> m_indexes;
+};
+
+// 请求行长度上限（字节），超出视为非法请求
+static const size_t MAX_REQUEST_LINE = 64 * 1024;
+
+// 带缓冲的套接字读取
+class SocketReader {
+public:
+    explicit SocketReader(int fd) : m_fd(fd) {}
+
+    bool read_line(std::string& line) {
+        while (true) {
+            size_t pos = m_buf.find('\n');
+            if (pos != std::string::npos) {
+                line = m_buf.substr(0, pos);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                m_buf.erase(0, pos + 1);
+                return true;
+            }
+            if (m_buf.size() > MAX_REQUEST_LINE || !fill()) return false;
+        }
+    }
+
+    bool read_bytes(size_t n, std::string& out) {
+        while (m_buf.size() < n) {
+            if (!fill()) return false;
+        }
+        out = m_buf.substr(0, n);
+        m_buf.erase(0, n);
+        return true;
+    }
+
+private:
+    bool fill() {
+        char chunk[65536];
+        ssize_t n = recv(m_fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        m_buf.append(chunk, n);
+        return true;
+    }
+
+    int m_fd;
+    std::string m_buf;
+};
+
+static bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+static bool read_request(SocketReader& reader, size_t max_csv_bytes, JobRequest& req, std::string& error) {
+    std::string line;
+    while (reader.read_line(line)) {
+        if (line.empty()) continue;
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = (space == std::string::npos) ? "" : line.substr(space + 1);
+        if (key == "end") {
+            if (req.img_dir.empty() || (req.csv_path.empty() && req.csv_text.empty())) {
+                error = "缺少images或csv/csv_data";
+                return false;
+            }
+            return true;
+        } else if (key == "csv") {
+            req.csv_path = value;
+        } else if (key == "csv_data") {
+            // 长度先校验再读取，避免按客户端给出的任意长度缓冲
+            char* end = nullptr;
+            errno = 0;
+            unsigned long long len = strtoull(value.c_str(), &end, 10);
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || *end != '\0' ||
+                errno == ERANGE) {
+                error = "csv_data长度无效：" + value;
+                return false;
+            }
+            if (len > max_csv_bytes) {
+                error = "CSV内容超出上限（" + std::to_string(max_csv_bytes) + "字节）";
+                return false;
+            }
+            if (!reader.read_bytes((size_t)len, req.csv_text)) {
+                error = "CSV内容不完整";
+                return false;
+            }
+        } else if (key == "images") {
+            req.img_dir = value;
+        } else if (key == "output") {
+            req.pdf_output = value;
+        } else if (key == "threshold") {
+            req.confidence = atof(value.c_str());
+        } else {
+            error = "未知请求项：" + key;
+            return false;
+        }
+    }
+    error = "请求不完整";
+    return false;
+}
+
+// 服务运行状态（各连接线程共用）
+struct ServerState {
+    const ServeConfig* config;
+    ThreadPool* pool;
+    ImageIndexCache indexes;
+    std::atomic<int> next_job_id{1};
+
+    // 公平调度：每个作业的在途识别单元配额 = 线程池线程数*2 / 进行中的作业数
+    std::atomic<size_t> inflight_share{0};
+    std::mutex job_mutex;
+    size_t active_jobs = 0;
+
+    // 进行中的连接数（停止时等待归零）
+    std::mutex conn_mutex;
+    std::condition_variable conn_done;
+    size_t active_conns = 0;
+
+    void job_started() {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        active_jobs++;
+        inflight_share = std::max<size_t>(1, (size_t)pool->size() * 2 / active_jobs);
+    }
+    void job_finished() {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        active_jobs--;
+        inflight_share = std::max<size_t>(1, (size_t)pool->size() * 2 / std::max<size_t>(1, active_jobs));
+    }
+};
+
+static void handle_connection(ServerState& state, int fd) {
+    SocketReader reader(fd);
+    JobRequest req;
+    std::string error;
+    if (!read_request(reader, state.config->max_csv_bytes, req, error)) {
+        send_all(fd, "ERROR\t" + error + "\n");
+        return;
+    }
+
+    int job_id = state.next_job_id++;
+    auto start = std::chrono::steady_clock::now();
+    send_all(fd, "ACCEPTED\t" + std::to_string(job_id) + "\n");
+
+    std::shared_ptr<const ImageIndex> index = state.indexes.get(req.img_dir);
+    if (!index) {
+        send_all(fd, "ERROR\t图片目录索引建立失败：" + req.img_dir + "\n");
+        return;
+    }
+
+    PipelineConfig pipeline_config;
+    pipeline_config.csv_path = req.csv_path;
+    pipeline_config.csv_text = std::move(req.csv_text);
+    pipeline_config.pdf_output = req.pdf_output;
+    pipeline_config.confidence = (req.confidence > 0) ? req.confidence : state.config->confidence;
+    pipeline_config.report_layout = state.config->report_layout;
+    pipeline_config.inflight_share = &state.inflight_share;
+    if (!req.pdf_output.empty()) {
+        size_t slash = req.pdf_output.find_last_of('/');
+        std::string pdf_dir = (slash == std::string::npos) ? "." : (slash > 0 ? req.pdf_output.substr(0, slash) : "/");
+        if (slash != std::string::npos && slash > 0) create_dir(pdf_dir);
+        if (state.config->annotate) pipeline_config.annotate.out_dir = pdf_dir + "/annotated";
+    }
+
+    // 结果写入报告后立即返回给客户端（客户端断开后不再发送，作业继续完成）
+    bool client_alive = true;
+    pipeline_config.on_result = [fd, &client_alive](const OcrResult& res) {
+        if (!client_alive) return;
+        std::ostringstream line;
+        line << "RESULT";
+        write_result_fields(line, res);
+        line << "\n";
+        client_alive = send_all(fd, line.str());
+    };
+
+    PipelineStats stats;
+    state.job_started();
+    bool ok = run_pipeline(pipeline_config, *index, *state.pool, stats);
+    state.job_finished();
+
+    long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "作业#" << job_id << "完成：" << stats.results << "条结果，耗时" << elapsed_ms << "ms" << std::endl;
+    if (!ok) {
+        send_all(fd, "ERROR\t识别流水线执行失败\n");
+    } else if (stats.rows == 0) {
+        send_all(fd, "ERROR\tCSV解析失败或无有效多语种数据\n");
+    } else {
+        send_all(fd, "DONE\t" + std::to_string(stats.rows) + "\t" + std::to_string(stats.results) + "\t" +
+                     std::to_string(stats.missing_images) + "\t" + std::to_string(elapsed_ms) + "\n");
+    }
+}
+
+bool run_job_server(const ServeConfig& config, ThreadPool& pool) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (config.socket_path.empty() || config.socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "套接字路径无效：" << config.socket_path << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, config.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "创建套接字失败：" << strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(config.socket_path.c_str());
+    if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0) {
+        std::cerr << "监听套接字失败：" << config.socket_path << " - " << strerror(errno) << std::endl;
+        close(listen_fd);
+        return false;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    ServerState state;
+    state.config = &config;
+    state.pool = &pool;
+    state.inflight_share = (size_t)pool.size() * 2;
+    std::cout << "服务已启动：" << config.socket_path << "（" << pool.size() << "个识别线程）" << std::endl;
+
+    while (!g_serve_stop) {
+        pollfd pfd;
+        pfd.fd = listen_fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 500) <= 0) continue;
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        // 客户端长时间不发送请求时放弃该连接，避免停止服务时一直等待
+        timeval timeout;
+        timeout.tv_sec = 30;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        {
+            std::lock_guard<std::mutex> lock(state.conn_mutex);
+            state.active_conns++;
+        }
+        std::thread([&state, fd]() {
+            try {
+                handle_connection(state, fd);
+            } catch (const std::exception& e) {
+                std::cerr << "作业处理异常：" << e.what() << std::endl;
+            }
+            close(fd);
+            std::lock_guard<std::mutex> lock(state.conn_mutex);
+            state.active_conns--;
+            state.conn_done.notify_all();
+        }).detach();
+    }
+
+    close(listen_fd);
+    unlink(config.socket_path.c_str());
+    std::cout << "服务停止：等待进行中的作业结束" << std::endl;
+    std::unique_lock<std::mutex> lock(state.conn_mutex);
+    state.conn_done.wait(lock, [&state]() { return state.active_conns == 0; });
+    return true;
+}
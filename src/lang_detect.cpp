@@ -0,0 +1,181 @@
+#include "lang_detect.h"
+#include "data_struct.h"
+#include "utf8_utils.h"
+#include <fstream>
+#include <iostream>
+#include <deque>
+#include <mutex>
+#include <climits>
+
+// 未命中任何关键词时的语种
+static const char* DEFAULT_LANG = "英语";
+
+// 多模式匹配自动机（Aho-Corasick，失配转移预先展开为完整的字节转移表）
+struct LangAutomaton {
+    std::vector<int> next;              // 状态*256+字节 -> 下一状态
+    std::vector<int> best;              // 状态 -> 该状态可确认的最高优先级（语种下标，越小越优先），INT_MAX为无
+    std::vector<std::string> langs;     // 语种下标 -> 语种名称
+};
+
+static LangAutomaton g_automaton;
+static std::once_flag g_default_once;
+static bool g_custom_keywords = false;
+
+const std::vector<LangKeyword>& default_lang_keywords() {
+    static const std::vector<LangKeyword> keywords = {
+        {"英语", "englist"},
+        {"英语", "english"},
+        {"英语", "uk"},
+        {"法语", "french"},
+        {"德语", "deutsch"},
+        {"德语", "german"},
+        {"俄语", "русский"},
+        {"俄语", "russian"},
+        {"西班牙语", "español"},
+        {"西班牙语", "spanish"},
+        {"葡萄牙语", "português"},
+        {"葡萄牙语", "portuguese"},
+        {"意大利语", "italiano"},
+        {"意大利语", "italian"},
+        {"土耳其语", "türkçe"},
+        {"土耳其语", "turkish"},
+        {"泰语", "ไทย"},
+        {"泰语", "thai"},
+        {"阿拉伯语", "العربية"},
+        {"阿拉伯语", "arabic"},
+    };
+    return keywords;
+}
+
+bool load_lang_keywords(const std::string& path, std::vector<LangKeyword>& keywords) {
+    std::ifstream in(path, std::ios::in);
+    if (!in) {
+        std::cerr << "无法打开语种关键词表：" << path << std::endl;
+        return false;
+    }
+
+    keywords.clear();
+    std::string line;
+    int line_num = 0;
+    while (std::getline(in, line)) {
+        line_num++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t comma = line.find(',');
+        if (comma == std::string::npos || comma == 0 || comma + 1 == line.size()) {
+            std::cerr << "语种关键词表第" << line_num << "行格式错误，跳过！" << std::endl;
+            continue;
+        }
+        LangKeyword item;
+        item.lang = line.substr(0, comma);
+        item.keyword = line.substr(comma + 1);
+        if (LANG_CODE_MAP.find(item.lang) == LANG_CODE_MAP.end()) {
+            std::cerr << "语种关键词表第" << line_num << "行：不支持的语种[" << item.lang << "]，跳过！" << std::endl;
+            continue;
+        }
+        keywords.push_back(item);
+    }
+    return !keywords.empty();
+}
+
+// 折叠大小写后的UTF-8字节序列（关键词与文言使用同一规则）
+static void append_folded(std::string& out, char32_t cp) {
+    utf8_append(out, fold_case(cp));
+}
+
+static bool build_automaton(const std::vector<LangKeyword>& keywords, LangAutomaton& automaton) {
+    automaton = LangAutomaton();
+    std::vector<std::vector<int>> children(1, std::vector<int>(256, -1));
+    automaton.best.push_back(INT_MAX);
+
+    // 1. 关键词插入字典树，终止状态记录语种优先级
+    for (const auto& item : keywords) {
+        int priority = -1;
+        for (size_t i = 0; i < automaton.langs.size(); i++) {
+            if (automaton.langs[i] == item.lang) priority = (int)i;
+        }
+        if (priority < 0) {
+            priority = (int)automaton.langs.size();
+            automaton.langs.push_back(item.lang);
+        }
+
+        std::string folded;
+        size_t pos = 0;
+        while (pos < item.keyword.size()) append_folded(folded, utf8_next(item.keyword, pos));
+        if (folded.empty()) continue;
+
+        int state = 0;
+        for (unsigned char c : folded) {
+            if (children[state][c] < 0) {
+                children[state][c] = (int)children.size();
+                children.emplace_back(256, -1);
+                automaton.best.push_back(INT_MAX);
+            }
+            state = children[state][c];
+        }
+        automaton.best[state] = std::min(automaton.best[state], priority);
+    }
+    if (automaton.langs.empty()) return false;
+
+    // 2. 按层展开失配转移，并沿失配链合并可确认的优先级
+    size_t state_num = children.size();
+    automaton.next.assign(state_num * 256, 0);
+    std::vector<int> fail(state_num, 0);
+    std::deque<int> queue;
+    for (int c = 0; c < 256; c++) {
+        int child = children[0][c];
+        if (child >= 0) {
+            automaton.next[c] = child;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        int state = queue.front();
+        queue.pop_front();
+        automaton.best[state] = std::min(automaton.best[state], automaton.best[fail[state]]);
+        for (int c = 0; c < 256; c++) {
+            int child = children[state][c];
+            int fallback = automaton.next[(size_t)fail[state] * 256 + c];
+            if (child >= 0) {
+                fail[child] = fallback;
+                automaton.next[(size_t)state * 256 + c] = child;
+                queue.push_back(child);
+            } else {
+                automaton.next[(size_t)state * 256 + c] = fallback;
+            }
+        }
+    }
+    return true;
+}
+
+bool set_lang_keywords(const std::vector<LangKeyword>& keywords) {
+    LangAutomaton automaton;
+    if (!build_automaton(keywords, automaton)) {
+        std::cerr << "语种关键词表为空！" << std::endl;
+        return false;
+    }
+    g_automaton = std::move(automaton);
+    g_custom_keywords = true;
+    return true;
+}
+
+std::string detect_lang(std::string_view text) {
+    if (!g_custom_keywords) {
+        std::call_once(g_default_once, []() { build_automaton(default_lang_keywords(), g_automaton); });
+    }
+
+    int state = 0;
+    int best = INT_MAX;
+    std::string folded;
+    size_t pos = 0;
+    while (pos < text.size() && best != 0) {
+        folded.clear();
+        append_folded(folded, utf8_next(text, pos));
+        for (unsigned char c : folded) {
+            state = g_automaton.next[(size_t)state * 256 + c];
+            best = std::min(best, g_automaton.best[state]);
+        }
+    }
+    return best == INT_MAX ? DEFAULT_LANG : g_automaton.langs[best];
+}
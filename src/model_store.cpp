@@ -0,0 +1,75 @@
+#include "model_store.h"
+#include "hash_utils.h"
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::mutex g_model_mutex;
+static std::map<std::string, MappedModel> g_models;   // 模型文件路径 -> 映射（快速模型与精确模型分别登记；映射失败的不登记，下次重试）
+
+bool map_model_file(const std::string& tessdata_dir, const std::string& lang_code, MappedModel& model) {
+    std::string path = tessdata_dir + "/" + lang_code + ".traineddata";
+    std::lock_guard<std::mutex> lock(g_model_mutex);
+    auto it = g_models.find(path);
+    if (it != g_models.end()) {
+        model = it->second;
+        return true;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // 共享只读映射：多个引擎初始化时读取的是同一份页缓存，不再各自读入文件
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, st.st_size, MADV_WILLNEED);
+
+    MappedModel mapped;
+    mapped.data = (const char*)data;
+    mapped.size = (size_t)st.st_size;
+    mapped.hash = hash_bytes(data, st.st_size);
+    g_models[path] = mapped;
+    model = mapped;
+    return true;
+}
+
+size_t mapped_model_count() {
+    std::lock_guard<std::mutex> lock(g_model_mutex);
+    return g_models.size();
+}
+
+size_t mapped_model_bytes() {
+    std::lock_guard<std::mutex> lock(g_model_mutex);
+    size_t total = 0;
+    for (const auto& item : g_models) total += item.second.size;
+    return total;
+}
+
+void unmap_model_files() {
+    std::lock_guard<std::mutex> lock(g_model_mutex);
+    for (auto& item : g_models) {
+        munmap((void*)item.second.data, item.second.size);
+    }
+    g_models.clear();
+}
+
+size_t process_rss_bytes() {
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp) return 0;
+    unsigned long size_pages = 0;
+    unsigned long rss_pages = 0;
+    int n = fscanf(fp, "%lu %lu", &size_pages, &rss_pages);
+    fclose(fp);
+    if (n != 2) return 0;
+    return (size_t)rss_pages * (size_t)sysconf(_SC_PAGESIZE);
+}
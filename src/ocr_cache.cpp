@@ -0,0 +1,427 @@
+#include "ocr_cache.h"
+#include "hash_utils.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <ctime>
+
+// 索引文件头
+struct IndexHeader {
+    char magic[8];          // "OCRIDX1"
+    uint64_t capacity;      // 槽位数（2的幂）
+    uint64_t count;         // 已用槽位数
+    uint64_t data_size;     // data.bin中有效数据长度
+};
+
+// 索引槽位（key全0表示空槽）
+struct IndexSlot {
+    uint64_t key_hi;
+    uint64_t key_lo;
+    uint64_t offset;        // 数据在data.bin中的偏移
+    uint32_t length;        // 数据长度
+    uint32_t last_used;     // 最近一次使用的运行时间戳（秒）
+};
+
+static const char INDEX_MAGIC[8] = {'O', 'C', 'R', 'I', 'D', 'X', '1', 0};
+static const uint64_t INITIAL_CAPACITY = 4096;
+static const uint8_t PAYLOAD_VERSION = 2;   // 2：增加行框与单词框（旧版本记录视为未命中）
+
+// 缓存全局状态（g_cache_mutex保护）；数据文件描述符另由g_data_lock保护：
+// 读取数据时持共享锁（不持g_cache_mutex），替换或关闭数据文件时持独占锁；加锁顺序为先g_data_lock后g_cache_mutex
+static std::shared_mutex g_data_lock;
+static std::mutex g_cache_mutex;
+static std::string g_cache_dir;
+static size_t g_max_bytes = 0;
+static int g_index_fd = -1;
+static int g_data_fd = -1;
+static IndexHeader* g_header = nullptr;
+static IndexSlot* g_slots = nullptr;
+static size_t g_map_size = 0;
+static bool g_store_disabled = false;   // 索引扩容失败后不再写入（已有条目仍可读取）
+static size_t g_hits = 0;
+static size_t g_misses = 0;
+
+static size_t index_file_size(uint64_t capacity) {
+    return sizeof(IndexHeader) + capacity * sizeof(IndexSlot);
+}
+
+static bool map_index(uint64_t capacity, bool reset) {
+    if (g_header) {
+        munmap(g_header, g_map_size);
+        g_header = nullptr;
+        g_slots = nullptr;
+    }
+    size_t size = index_file_size(capacity);
+    if (reset && ftruncate(g_index_fd, 0) != 0) return false;
+    if (ftruncate(g_index_fd, size) != 0) return false;
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, g_index_fd, 0);
+    if (addr == MAP_FAILED) return false;
+    g_map_size = size;
+    g_header = (IndexHeader*)addr;
+    g_slots = (IndexSlot*)((char*)addr + sizeof(IndexHeader));
+    if (reset) {
+        memcpy(g_header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        g_header->capacity = capacity;
+        g_header->count = 0;
+        g_header->data_size = 0;
+    }
+    return true;
+}
+
+// 线性探测：返回key所在槽位或应插入的空槽
+static IndexSlot* probe_slot(IndexSlot* slots, uint64_t capacity, uint64_t key_hi, uint64_t key_lo) {
+    uint64_t mask = capacity - 1;
+    for (uint64_t i = key_lo & mask;; i = (i + 1) & mask) {
+        IndexSlot* slot = &slots[i];
+        if ((slot->key_hi == 0 && slot->key_lo == 0) || (slot->key_hi == key_hi && slot->key_lo == key_lo)) {
+            return slot;
+        }
+    }
+}
+
+// 索引装载率超过70%时扩容并重新散列
+static bool grow_index() {
+    uint64_t old_capacity = g_header->capacity;
+    std::vector<IndexSlot> live;
+    live.reserve(g_header->count);
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (g_slots[i].key_hi != 0 || g_slots[i].key_lo != 0) live.push_back(g_slots[i]);
+    }
+    uint64_t data_size = g_header->data_size;
+
+    if (!map_index(old_capacity * 2, true)) return false;
+    g_header->data_size = data_size;
+    for (const auto& slot : live) {
+        *probe_slot(g_slots, g_header->capacity, slot.key_hi, slot.key_lo) = slot;
+    }
+    g_header->count = live.size();
+    return true;
+}
+
+static void close_files() {
+    if (g_header) {
+        msync(g_header, g_map_size, MS_SYNC);
+        munmap(g_header, g_map_size);
+    }
+    if (g_index_fd >= 0) {
+        flock(g_index_fd, LOCK_UN);
+        close(g_index_fd);
+    }
+    if (g_data_fd >= 0) close(g_data_fd);
+    g_header = nullptr;
+    g_slots = nullptr;
+    g_index_fd = -1;
+    g_data_fd = -1;
+}
+
+OcrCacheKey make_ocr_cache_key(uint64_t image_hash, const std::string& lang_code,
+                               const std::string& settings, uint64_t model_hash) {
+    std::string material = hash_to_hex(image_hash) + "|" + lang_code + "|" + settings + "|" + hash_to_hex(model_hash);
+    OcrCacheKey key;
+    key.hi = hash_string(material, 0x9e3779b97f4a7c15ULL);
+    key.lo = hash_string(material, 0x632be59bd9b4e019ULL);
+    if (key.hi == 0 && key.lo == 0) key.lo = 1;
+    return key;
+}
+
+bool ocr_cache_open(const std::string& cache_dir, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (g_header) return true;
+
+    mkdir(cache_dir.c_str(), 0755);
+    std::string index_path = cache_dir + "/index.bin";
+    std::string data_path = cache_dir + "/data.bin";
+    g_index_fd = open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+    g_data_fd = open(data_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (g_index_fd < 0 || g_data_fd < 0) {
+        std::cerr << "无法打开识别结果缓存：" << cache_dir << std::endl;
+        close_files();
+        return false;
+    }
+    // 同一缓存目录只允许一个进程写入
+    if (flock(g_index_fd, LOCK_EX | LOCK_NB) != 0) {
+        std::cerr << "识别结果缓存正被其他进程使用，本次不使用缓存：" << cache_dir << std::endl;
+        close_files();
+        return false;
+    }
+
+    struct stat index_st, data_st;
+    fstat(g_index_fd, &index_st);
+    fstat(g_data_fd, &data_st);
+
+    bool valid = false;
+    if ((size_t)index_st.st_size >= sizeof(IndexHeader)) {
+        IndexHeader header;
+        if (pread(g_index_fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+            memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+            header.capacity >= INITIAL_CAPACITY && (header.capacity & (header.capacity - 1)) == 0 &&
+            (size_t)index_st.st_size == index_file_size(header.capacity) &&
+            header.data_size <= (uint64_t)data_st.st_size) {
+            valid = map_index(header.capacity, false);
+        }
+    }
+    if (!valid) {
+        // 索引缺失或损坏：整体重建
+        if (!map_index(INITIAL_CAPACITY, true) || ftruncate(g_data_fd, 0) != 0) {
+            std::cerr << "识别结果缓存初始化失败：" << cache_dir << std::endl;
+            close_files();
+            return false;
+        }
+    } else if ((uint64_t)data_st.st_size > g_header->data_size) {
+        // 丢弃上次异常退出时未登记到索引的尾部数据
+        if (ftruncate(g_data_fd, g_header->data_size) != 0) {
+            close_files();
+            return false;
+        }
+    }
+
+    g_cache_dir = cache_dir;
+    g_max_bytes = max_bytes;
+    g_store_disabled = false;
+    g_hits = 0;
+    g_misses = 0;
+    return true;
+}
+
+bool ocr_cache_enabled() {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    return g_header != nullptr;
+}
+
+static std::string serialize_entry(const OcrCacheKey& key, const OcrCacheEntry& entry) {
+    std::string out;
+    out.append((const char*)&key.lo, sizeof(key.lo));
+    out += (char)PAYLOAD_VERSION;
+    out.append((const char*)&entry.confidence, sizeof(entry.confidence));
+    uint8_t box_num = (uint8_t)std::min<size_t>(entry.box.size(), 255);
+    out += (char)box_num;
+    for (uint8_t i = 0; i < box_num; i++) {
+        int32_t v = entry.box[i];
+        out.append((const char*)&v, sizeof(v));
+    }
+    uint32_t text_len = entry.text.size();
+    out.append((const char*)&text_len, sizeof(text_len));
+    out += entry.text;
+
+    uint32_t box_count = entry.text_boxes.size();
+    out.append((const char*)&box_count, sizeof(box_count));
+    for (const auto& box : entry.text_boxes) {
+        int32_t values[4] = {box.x, box.y, box.w, box.h};
+        uint32_t len = box.text.size();
+        out += (char)box.level;
+        out.append((const char*)values, sizeof(values));
+        out.append((const char*)&box.confidence, sizeof(box.confidence));
+        out.append((const char*)&len, sizeof(len));
+        out += box.text;
+    }
+    return out;
+}
+
+static bool deserialize_entry(const std::string& data, const OcrCacheKey& key, OcrCacheEntry& entry) {
+    size_t pos = 0;
+    auto read = [&](void* dst, size_t len) {
+        if (pos + len > data.size()) return false;
+        memcpy(dst, data.data() + pos, len);
+        pos += len;
+        return true;
+    };
+    uint64_t key_lo;
+    uint8_t version, box_num;
+    if (!read(&key_lo, sizeof(key_lo)) || key_lo != key.lo) return false;
+    if (!read(&version, 1) || version != PAYLOAD_VERSION) return false;
+    if (!read(&entry.confidence, sizeof(entry.confidence)) || !read(&box_num, 1)) return false;
+    entry.box.assign(box_num, 0);
+    for (uint8_t i = 0; i < box_num; i++) {
+        int32_t v;
+        if (!read(&v, sizeof(v))) return false;
+        entry.box[i] = v;
+    }
+    uint32_t text_len;
+    if (!read(&text_len, sizeof(text_len)) || pos + text_len > data.size()) return false;
+    entry.text.assign(data.data() + pos, text_len);
+    pos += text_len;
+
+    uint32_t box_count;
+    if (!read(&box_count, sizeof(box_count))) return false;
+    entry.text_boxes.clear();
+    for (uint32_t i = 0; i < box_count; i++) {
+        OcrTextBox box;
+        uint8_t level;
+        int32_t values[4];
+        uint32_t len;
+        if (!read(&level, 1) || !read(values, sizeof(values)) || !read(&box.confidence, sizeof(box.confidence)) ||
+            !read(&len, sizeof(len)) || pos + len > data.size()) {
+            return false;
+        }
+        box.level = level;
+        box.x = values[0];
+        box.y = values[1];
+        box.w = values[2];
+        box.h = values[3];
+        box.text.assign(data.data() + pos, len);
+        pos += len;
+        entry.text_boxes.push_back(std::move(box));
+    }
+    return true;
+}
+
+bool ocr_cache_lookup(const OcrCacheKey& key, OcrCacheEntry& entry) {
+    uint64_t offset;
+    uint32_t length;
+    int data_fd;
+    std::shared_lock<std::shared_mutex> data_lock(g_data_lock);
+    {
+        std::lock_guard<std::mutex> lock(g_cache_mutex);
+        if (!g_header) return false;
+        IndexSlot* slot = probe_slot(g_slots, g_header->capacity, key.hi, key.lo);
+        if (slot->key_hi == 0 && slot->key_lo == 0) {
+            g_misses++;
+            return false;
+        }
+        slot->last_used = (uint32_t)time(nullptr);
+        offset = slot->offset;
+        length = slot->length;
+        data_fd = g_data_fd;
+    }
+
+    // 数据文件只追加，持有共享锁期间不会被压缩替换或关闭，读取无需持g_cache_mutex
+    std::string data(length, '\0');
+    bool ok = pread(data_fd, &data[0], length, offset) == (ssize_t)length && deserialize_entry(data, key, entry);
+
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (ok) g_hits++;
+    else g_misses++;
+    return ok;
+}
+
+bool ocr_cache_contains(const OcrCacheKey& key) {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (!g_header) return false;
+    IndexSlot* slot = probe_slot(g_slots, g_header->capacity, key.hi, key.lo);
+    return slot->key_hi != 0 || slot->key_lo != 0;
+}
+
+static bool over_limit() {
+    return g_header && g_max_bytes > 0 && g_header->data_size > g_max_bytes;
+}
+
+static bool evict_and_compact();
+
+void ocr_cache_store(const OcrCacheKey& key, const OcrCacheEntry& entry) {
+    std::string data = serialize_entry(key, entry);
+
+    {
+        std::lock_guard<std::mutex> lock(g_cache_mutex);
+        if (!g_header || g_store_disabled) return;
+        if ((g_header->count + 1) * 10 > g_header->capacity * 7 && !grow_index()) {
+            // 其他线程可能正在读取数据文件，这里不关闭文件，只停止写入
+            std::cerr << "识别结果缓存索引扩容失败，停止写入缓存" << std::endl;
+            g_store_disabled = true;
+            return;
+        }
+
+        uint64_t offset = g_header->data_size;
+        if (pwrite(g_data_fd, data.data(), data.size(), offset) != (ssize_t)data.size()) return;
+        g_header->data_size = offset + data.size();
+
+        IndexSlot* slot = probe_slot(g_slots, g_header->capacity, key.hi, key.lo);
+        if (slot->key_hi == 0 && slot->key_lo == 0) g_header->count++;
+        slot->offset = offset;
+        slot->length = data.size();
+        slot->last_used = (uint32_t)time(nullptr);
+        slot->key_lo = key.lo;
+        slot->key_hi = key.hi;
+        if (!over_limit()) return;
+    }
+
+    // 超出上限时立即淘汰（等待正在读取的线程完成后再替换数据文件）
+    std::unique_lock<std::shared_mutex> data_lock(g_data_lock);
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (over_limit() && !evict_and_compact() && g_header) {
+        // 压缩失败时停止写入，避免每次写入都重试整个数据文件的重写
+        std::cerr << "识别结果缓存压缩失败，停止写入缓存" << std::endl;
+        g_store_disabled = true;
+    }
+}
+
+// 数据超过上限时保留最近使用的条目（至上限的80%），重写数据文件并重建索引
+// 调用方须同时持有g_data_lock独占锁与g_cache_mutex；失败时返回false
+static bool evict_and_compact() {
+    std::vector<IndexSlot> live;
+    for (uint64_t i = 0; i < g_header->capacity; i++) {
+        if (g_slots[i].key_hi != 0 || g_slots[i].key_lo != 0) live.push_back(g_slots[i]);
+    }
+    std::sort(live.begin(), live.end(), [](const IndexSlot& a, const IndexSlot& b) {
+        return a.last_used > b.last_used;
+    });
+
+    size_t budget = g_max_bytes / 10 * 8;
+    std::string tmp_path = g_cache_dir + "/data.bin.tmp";
+    int tmp_fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmp_fd < 0) return false;
+
+    std::vector<IndexSlot> kept;
+    uint64_t new_size = 0;
+    std::string buf;
+    for (const auto& slot : live) {
+        if (new_size + slot.length > budget) continue;
+        buf.resize(slot.length);
+        if (pread(g_data_fd, &buf[0], slot.length, slot.offset) != (ssize_t)slot.length) continue;
+        if (pwrite(tmp_fd, buf.data(), slot.length, new_size) != (ssize_t)slot.length) break;
+        IndexSlot moved = slot;
+        moved.offset = new_size;
+        new_size += slot.length;
+        kept.push_back(moved);
+    }
+    fsync(tmp_fd);
+    if (rename(tmp_path.c_str(), (g_cache_dir + "/data.bin").c_str()) != 0) {
+        close(tmp_fd);
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    close(g_data_fd);
+    g_data_fd = tmp_fd;
+
+    uint64_t capacity = INITIAL_CAPACITY;
+    while (kept.size() * 10 > capacity * 7) capacity *= 2;
+    if (!map_index(capacity, true)) {
+        std::cerr << "识别结果缓存索引重建失败，关闭缓存" << std::endl;
+        close_files();
+        return false;
+    }
+    for (const auto& slot : kept) {
+        *probe_slot(g_slots, capacity, slot.key_hi, slot.key_lo) = slot;
+    }
+    g_header->count = kept.size();
+    g_header->data_size = new_size;
+    std::cout << "识别结果缓存淘汰" << (live.size() - kept.size()) << "条，保留" << kept.size() << "条" << std::endl;
+    return true;
+}
+
+void ocr_cache_close() {
+    std::unique_lock<std::shared_mutex> data_lock(g_data_lock);
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    if (!g_header) return;
+    if (over_limit()) evict_and_compact();
+    if (g_data_fd >= 0) fsync(g_data_fd);
+    close_files();
+}
+
+OcrCacheStats ocr_cache_stats() {
+    std::lock_guard<std::mutex> lock(g_cache_mutex);
+    OcrCacheStats stats;
+    stats.hits = g_hits;
+    stats.misses = g_misses;
+    if (g_header) {
+        stats.entries = g_header->count;
+        stats.data_bytes = g_header->data_size;
+    }
+    return stats;
+}
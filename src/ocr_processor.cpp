@@ -1,108 +1,702 @@
 #include "ocr_processor.h"
 #include "csv_utils.h"  // 引入工具函数，避免重复定义
+#include "text_matcher.h"
+#include "ocr_cache.h"
+#include "hash_utils.h"
+#include "trace.h"
+#include "model_store.h"
 #include <tesseract/baseapi.h>
-#include <leptonica/allheaders.h>
+#include <tesseract/genericvector.h>
+#include <tesseract/strngs.h>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
 #include <opencv2/opencv.hpp>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <map>
 #include <cstdio>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cmath>
+#include <climits>
+#include <algorithm>
 
-// 全局OCR引擎
-static tesseract::TessBaseAPI* g_tess_api = nullptr;
-static std::mutex g_ocr_mutex;
+// 引擎池全局配置（所有线程共用，初始化后只读）
+static std::string g_tessdata_dir;
+static bool g_engine_ready = false;
+static std::vector<std::string> g_preload_langs;
+static std::atomic<int> g_engine_count(0);
+static bool g_cascade = false;
 
-// 实现OCR引擎初始化函数
+static PreprocessConfig g_preprocess_config;
+
+// ROI识别区域表（初始化后只读）与学习到的区域
+static RegionMap g_region_map;
+static bool g_learn_regions = false;
+static RegionMap g_learned_regions;
+static std::mutex g_learn_mutex;
+
+// ROI裁剪时四周保留的边距（像素）
+static const int ROI_PADDING = 8;
+
+// 模型目录（未指定时使用TESSDATA_PREFIX）
+static std::string model_dir() {
+    if (g_tessdata_dir.empty() && getenv("TESSDATA_PREFIX")) return getenv("TESSDATA_PREFIX");
+    return g_tessdata_dir;
+}
+
+// 快速层模型目录（与tessdata_fast同名的模型文件，不存在时快速层沿用精确模型）
+static std::string fast_model_dir() {
+    return model_dir() + "/fast";
+}
+
+// 各语种是否有快速模型（首次查询时确定）
+static std::map<std::string, bool> g_fast_models;
+static std::mutex g_fast_models_mutex;
+
+static bool has_fast_model(const std::string& lang_code) {
+    std::lock_guard<std::mutex> lock(g_fast_models_mutex);
+    auto it = g_fast_models.find(lang_code);
+    if (it != g_fast_models.end()) return it->second;
+    MappedModel model;
+    bool found = map_model_file(fast_model_dir(), lang_code, model);
+    g_fast_models[lang_code] = found;
+    return found;
+}
+
+// 是否先走快速层：只有该语种有快速模型或记录命中识别区域时快速层才明显更快，
+// 否则快速层与精确层几乎同样耗时，直接按精确层识别
+static bool use_fast_tier(const std::string& lang_code, bool use_roi) {
+    return g_cascade && (use_roi || has_fast_model(lang_code));
+}
+
+// 线程私有引擎表：语种编码（快速层加"#fast"后缀） -> 已加载模型的引擎（线程退出时自动释放）
+struct ThreadEngines {
+    std::map<std::string, tesseract::TessBaseAPI*> engines;
+
+    void release() {
+        for (auto& item : engines) {
+            item.second->End();
+            delete item.second;
+            g_engine_count--;
+        }
+        engines.clear();
+    }
+    ~ThreadEngines() { release(); }
+};
+static thread_local ThreadEngines t_engines;
+static thread_local std::string t_last_engine_lang;
+
+// 获取当前线程指定语种、指定层级的引擎（首次使用时加载模型，之后复用）；
+// 快速层优先使用快速模型，并关闭系统词典与高频词词典
+static tesseract::TessBaseAPI* acquire_thread_engine(const std::string& lang_code, bool fast = false) {
+    std::string engine_key = fast ? lang_code + "#fast" : lang_code;
+    auto it = t_engines.engines.find(engine_key);
+    if (it != t_engines.engines.end()) {
+        if (trace_active() && t_last_engine_lang != engine_key) {
+            uint64_t now = trace_now_us();
+            trace_span(TRACE_ENGINE_SWITCH, now, now, lang_code);
+        }
+        t_last_engine_lang = engine_key;
+        return it->second;
+    }
+
+    TraceScope scope(TRACE_ENGINE_INIT, lang_code);
+    t_last_engine_lang = engine_key;
+    tesseract::TessBaseAPI* api = new tesseract::TessBaseAPI();
+
+    GenericVector<STRING> vars_vec;
+    GenericVector<STRING> vars_values;
+    if (fast) {
+        vars_vec.push_back("load_system_dawg");
+        vars_values.push_back("0");
+        vars_vec.push_back("load_freq_dawg");
+        vars_values.push_back("0");
+    }
+
+    // 优先从共享映射的模型缓冲区初始化（各线程的引擎不再各自读入模型文件），映射失败时按路径加载
+    MappedModel model;
+    int rc;
+    if ((fast && map_model_file(fast_model_dir(), lang_code, model)) || map_model_file(model_dir(), lang_code, model)) {
+        rc = api->Init(model.data, (int)model.size, lang_code.c_str(), tesseract::OEM_DEFAULT,
+                       nullptr, 0, &vars_vec, &vars_values, false, nullptr);
+    } else {
+        const char* datapath = g_tessdata_dir.empty() ? nullptr : g_tessdata_dir.c_str();
+        rc = api->Init(datapath, lang_code.c_str(), tesseract::OEM_DEFAULT, nullptr, 0, &vars_vec, &vars_values, false);
+    }
+    if (rc != 0) {
+        std::cerr << "加载语种模型失败：" << lang_code << (fast ? "（快速层）" : "") << std::endl;
+        delete api;
+        return nullptr;
+    }
+    // 设置OCR模式（仅识别文本）
+    api->SetPageSegMode(tesseract::PSM_AUTO);
+    t_engines.engines[engine_key] = api;
+    g_engine_count++;
+    return api;
+}
+
+// 实现OCR引擎初始化函数（仅记录配置并校验模型目录，引擎由各线程按需创建）
 bool init_ocr_engine(const std::string& tessdata_dir) {
-    g_tess_api = new tesseract::TessBaseAPI();
-    // 初始化通用引擎（后续按语种切换）
-    if (g_tess_api->Init(tessdata_dir.c_str(), "eng") != 0) {
-        std::cerr << "Tesseract初始化失败！" << std::endl;
-        delete g_tess_api;
-        g_tess_api = nullptr;
+    if (!tessdata_dir.empty() && access((tessdata_dir + "/eng.traineddata").c_str(), R_OK) != 0) {
+        std::cerr << "Tesseract初始化失败！未找到模型：" << tessdata_dir << "/eng.traineddata" << std::endl;
         return false;
     }
-    // 设置OCR模式（仅识别文本）
-    g_tess_api->SetPageSegMode(tesseract::PSM_AUTO);
+    g_tessdata_dir = tessdata_dir;
+    g_engine_ready = true;
     return true;
 }
 
+void set_engine_preload_langs(const std::vector<std::string>& lang_codes) {
+    g_preload_langs = lang_codes;
+}
+
+bool warm_up_thread_engines() {
+    bool ok = true;
+    for (const auto& lang_code : g_preload_langs) {
+        if (!acquire_thread_engine(lang_code)) ok = false;
+        if (use_fast_tier(lang_code, !g_region_map.empty()) && !acquire_thread_engine(lang_code, true)) ok = false;
+    }
+    return ok;
+}
+
+void release_thread_engines() {
+    t_engines.release();
+}
+
+int get_engine_count() {
+    return g_engine_count.load();
+}
+
 // 实现OCR引擎释放函数
 void release_ocr_engine() {
-    std::lock_guard<std::mutex> lock(g_ocr_mutex);
-    if (g_tess_api) {
-        g_tess_api->End();
-        delete g_tess_api;
-        g_tess_api = nullptr;
+    release_thread_engines();
+    unmap_model_files();
+    g_preload_langs.clear();
+    g_engine_ready = false;
+}
+
+void set_preprocess_config(const PreprocessConfig& config) {
+    g_preprocess_config = config;
+}
+
+void set_ocr_cascade(bool enabled) {
+    g_cascade = enabled;
+    std::lock_guard<std::mutex> lock(g_fast_models_mutex);
+    g_fast_models.clear();
+}
+
+// 估计二值图中文字的倾斜角度（度），前景像素过少时返回0
+static double estimate_skew_angle(const cv::Mat& binary) {
+    cv::Mat fg;
+    cv::bitwise_not(binary, fg);
+    std::vector<cv::Point> points;
+    cv::findNonZero(fg, points);
+    if (points.size() < 100) return 0;
+
+    cv::RotatedRect box = cv::minAreaRect(points);
+    double angle = box.angle;
+    if (box.size.width < box.size.height) angle += 90;
+    if (angle > 45) angle -= 90;
+    if (angle < -45) angle += 90;
+    return angle;
+}
+
+void set_region_config(const RegionMap& regions, bool learn) {
+    g_region_map = regions;
+    g_learn_regions = learn;
+}
+
+RegionMap get_learned_regions() {
+    std::lock_guard<std::mutex> lock(g_learn_mutex);
+    return g_learned_regions;
+}
+
+// 与识别同一遍：从结果迭代器取出各文本行与单词的位置、置信度（换算回原图坐标：先除以缩放比例，再加裁剪偏移）
+static void collect_text_boxes(tesseract::TessBaseAPI* api, double scale, int offset_x, int offset_y,
+                               std::vector<OcrTextBox>& boxes) {
+    boxes.clear();
+    tesseract::ResultIterator* it = api->GetIterator();
+    if (!it) return;
+    auto read_box = [&](tesseract::PageIteratorLevel level, OcrTextBox& box) {
+        int left, top, right, bottom;
+        if (!it->BoundingBox(level, &left, &top, &right, &bottom)) return false;
+        box.x = (int)(left / scale) + offset_x;
+        box.y = (int)(top / scale) + offset_y;
+        box.w = (int)((right - left) / scale + 0.5);
+        box.h = (int)((bottom - top) / scale + 0.5);
+        box.confidence = it->Confidence(level) / 100.0f;
+        return true;
+    };
+    do {
+        if (it->Empty(tesseract::RIL_WORD)) continue;
+        if (it->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) {
+            OcrTextBox line;
+            line.level = OCR_BOX_LINE;
+            if (read_box(tesseract::RIL_TEXTLINE, line)) boxes.push_back(line);
+        }
+        OcrTextBox word;
+        char* word_text = it->GetUTF8Text(tesseract::RIL_WORD);
+        if (word_text) {
+            word.text = word_text;
+            delete[] word_text;
+        }
+        if (read_box(tesseract::RIL_WORD, word)) boxes.push_back(std::move(word));
+    } while (it->Next(tesseract::RIL_WORD));
+    delete it;
+}
+
+// 在各文本行中查找与期望文言最相似的片段，标记该片段的单词与所在行；
+// 返回匹配行在boxes中的下标（未找到返回-1），score返回相似度
+static int mark_matched_span(std::vector<OcrTextBox>& boxes, const std::string& expected, const std::string& lang_code,
+                             double& score) {
+    score = 0;
+    for (auto& box : boxes) box.matched = false;
+    std::u32string target = normalize_for_match(expected, lang_code);
+    if (target.empty()) return -1;
+
+    // 泰语规范化时去除字间空白，其余语种单词之间以一个空格相连（与整段文本的规范化一致）
+    bool join_space = (lang_code != "tha");
+    int best_line = -1;
+    int best_begin_cp = 0, best_end_cp = 0;
+    std::vector<std::pair<int, int>> best_ranges;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (boxes[i].level != OCR_BOX_LINE) continue;
+        // 拼接本行单词的规范化文本，记录各单词的码点区间
+        std::u32string line_text;
+        std::vector<std::pair<int, int>> ranges;
+        for (size_t j = i + 1; j < boxes.size() && boxes[j].level == OCR_BOX_WORD; j++) {
+            std::u32string word = normalize_for_match(boxes[j].text, lang_code);
+            if (!word.empty() && !line_text.empty() && join_space) line_text.push_back(' ');
+            int begin = (int)line_text.size();
+            line_text += word;
+            ranges.push_back(std::make_pair(begin, (int)line_text.size()));
+        }
+        TextMatch match = find_best_match(target, line_text, (int)(target.size() * (1 - score)));
+        if (match.distance >= 0 && match.score > score) {
+            score = match.score;
+            best_line = (int)i;
+            best_begin_cp = match.begin;
+            best_end_cp = match.end;
+            best_ranges = ranges;
+        }
     }
+    if (best_line < 0) return -1;
+
+    boxes[best_line].matched = true;
+    for (size_t k = 0; k < best_ranges.size(); k++) {
+        const auto& range = best_ranges[k];
+        if (range.first < range.second && range.first < best_end_cp && range.second > best_begin_cp) {
+            boxes[best_line + 1 + k].matched = true;
+        }
+    }
+    return best_line;
 }
 
-// 实现图片处理函数
-OcrResult process_image(const std::string& img_path, const CsvMeta& csv_meta, double confidence_threshold) {
+cv::Mat preprocess_image(const cv::Mat& src, const PreprocessConfig& config, double* scale_out) {
+    if (scale_out) *scale_out = 1.0;
+
+    // 1. 灰度化
+    cv::Mat gray;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    } else if (src.channels() == 4) {
+        cv::cvtColor(src, gray, cv::COLOR_BGRA2GRAY);
+    } else {
+        gray = src;
+    }
+
+    // 2. 反色：深色主题界面（浅色文字+深色背景）转为深色文字+浅色背景
+    bool invert = (config.invert == 1) || (config.invert < 0 && cv::mean(gray)[0] < 128);
+    if (invert) {
+        cv::Mat inverted;
+        cv::bitwise_not(gray, inverted);
+        gray = inverted;
+    }
+
+    // 3. 按DPI归一化缩放，限制最长边
+    double scale = (config.source_dpi > 0) ? (double)config.target_dpi / config.source_dpi : 1.0;
+    int long_side = std::max(gray.cols, gray.rows);
+    if (long_side * scale > config.max_side) scale = (double)config.max_side / long_side;
+    if (scale > 1.01 || scale < 0.99) {
+        cv::Mat scaled;
+        cv::resize(gray, scaled, cv::Size(), scale, scale, scale > 1 ? cv::INTER_CUBIC : cv::INTER_AREA);
+        gray = scaled;
+        if (scale_out) *scale_out = scale;
+    }
+
+    // 4. 自适应阈值二值化（抵抗渐变背景与阴影）
+    cv::Mat out = gray;
+    if (config.binarize) {
+        int block_size = std::max(3, config.block_size | 1);
+        cv::adaptiveThreshold(gray, out, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, block_size, config.thresh_c);
+    }
+
+    // 5. 倾斜校正（仅处理小角度，避免误转）
+    if (config.deskew && config.binarize) {
+        double angle = estimate_skew_angle(out);
+        if (std::abs(angle) > 0.3 && std::abs(angle) < 15) {
+            cv::Point2f center(out.cols / 2.0f, out.rows / 2.0f);
+            cv::Mat rot = cv::getRotationMatrix2D(center, angle, 1.0);
+            cv::Mat rotated;
+            cv::warpAffine(out, rotated, rot, out.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+            out = rotated;
+        }
+    }
+    return out;
+}
+
+// 读取文件全部字节
+static bool read_file_bytes(const std::string& path, std::vector<unsigned char>& bytes) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) return false;
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (size <= 0) return false;
+    bytes.resize((size_t)size);
+    return (bool)file.read((char*)bytes.data(), size);
+}
+
+static void decode_bytes(DecodedImage& img, std::vector<unsigned char>& bytes) {
+    img.image = cv::imdecode(cv::Mat(1, (int)bytes.size(), CV_8UC1, bytes.data()), cv::IMREAD_COLOR);
+}
+
+// 读取文件字节：计算内容哈希（缓存键），再从内存解码，避免二次读盘
+DecodedImage load_image(const std::string& img_path, bool decode) {
+    DecodedImage img;
+    img.path = img_path;
+    std::vector<unsigned char> bytes;
+    if (!read_file_bytes(img_path, bytes)) return img;
+
+    img.content_hash = hash_bytes(bytes.data(), bytes.size());
+    if (decode) decode_bytes(img, bytes);
+    return img;
+}
+
+DecodedImage load_image_for_ocr(const std::string& img_path, const CsvMeta& csv_meta) {
+    DecodedImage img;
+    img.path = img_path;
+    std::vector<unsigned char> bytes;
+    if (!read_file_bytes(img_path, bytes)) return img;
+
+    img.content_hash = hash_bytes(bytes.data(), bytes.size());
+    if (ocr_cache_probe(img, csv_meta)) {
+        img.bytes.swap(bytes);
+    } else {
+        decode_bytes(img, bytes);
+    }
+    return img;
+}
+
+bool ensure_image_decoded(DecodedImage& img) {
+    if (!img.image.empty()) return true;
+    if (!img.bytes.empty()) {
+        decode_bytes(img, img.bytes);
+        std::vector<unsigned char>().swap(img.bytes);
+    } else if (img.content_hash != 0) {
+        img.image = cv::imread(img.path, cv::IMREAD_COLOR);
+    }
+    return !img.image.empty();
+}
+
+void prefetch_image_file(const std::string& img_path) {
+    int fd = open(img_path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+DecodedImage decode_image(const std::string& img_path) {
+    return load_image(img_path, true);
+}
+
+// 模型文件哈希（随模型映射计算，每个语种只计算一次）；快速层无快速模型时为精确模型的哈希
+static uint64_t model_file_hash(const std::string& lang_code, bool fast = false) {
+    MappedModel model;
+    if (fast && map_model_file(fast_model_dir(), lang_code, model)) return model.hash;
+    return map_model_file(model_dir(), lang_code, model) ? model.hash : 0;
+}
+
+// 页面分割模式：命中区域时按单行识别；快速层整页识别时按稀疏文本查找，跳过完整的版面分析
+static tesseract::PageSegMode page_seg_mode(bool use_roi, bool fast) {
+    if (use_roi) return tesseract::PSM_SINGLE_LINE;
+    return fast ? tesseract::PSM_SPARSE_TEXT : tesseract::PSM_AUTO;
+}
+
+// 影响识别结果的引擎设置（预处理参数、页面分割模式、识别区域与层级）
+static std::string engine_settings(const RegionRect* roi, bool fast = false) {
+    const PreprocessConfig& c = g_preprocess_config;
+    std::ostringstream out;
+    out << "pre=" << c.enabled << "," << c.binarize << "," << c.block_size << "," << c.thresh_c << ","
+        << c.source_dpi << "," << c.target_dpi << "," << c.max_side << "," << c.invert << "," << c.deskew;
+    if (roi) {
+        out << ";psm=line;roi=" << roi->x << "," << roi->y << "," << roi->w << "," << roi->h;
+    } else {
+        out << (fast ? ";psm=sparse" : ";psm=auto");
+    }
+    if (fast) out << ";tier=fast;dawg=0";
+    return out.str();
+}
+
+static bool make_cache_key(const DecodedImage& img, const std::string& lang_code, const RegionRect* roi, bool fast,
+                           OcrCacheKey& key) {
+    if (img.content_hash == 0 || !ocr_cache_enabled()) return false;
+    key = make_ocr_cache_key(img.content_hash, lang_code, engine_settings(roi, fast), model_file_hash(lang_code, fast));
+    return true;
+}
+
+bool ocr_cache_probe(const DecodedImage& img, const CsvMeta& csv_meta) {
+    if (csv_meta.lang_id == LANG_UNKNOWN) return false;
+    const std::string& lang_code = lang_code_of(csv_meta.lang_id);
+    RegionRect roi;
+    bool use_roi = find_region(g_region_map, csv_meta, roi);
+    // 级联时快速层结果已缓存即可跳过解码（未通过需要精确层时再补解码）
+    OcrCacheKey key;
+    if (use_fast_tier(lang_code, use_roi) && make_cache_key(img, lang_code, use_roi ? &roi : nullptr, true, key) &&
+        ocr_cache_contains(key)) {
+        return true;
+    }
+    return make_cache_key(img, lang_code, use_roi ? &roi : nullptr, false, key) && ocr_cache_contains(key);
+}
+
+std::string ocr_settings_fingerprint(const CsvMeta& csv_meta) {
+    const std::string& lang_code = lang_code_of(csv_meta.lang_id);
+    RegionRect roi;
+    bool use_roi = find_region(g_region_map, csv_meta, roi);
+    std::string fingerprint = lang_code + ";" + engine_settings(use_roi ? &roi : nullptr) + ";model=" + hash_to_hex(model_file_hash(lang_code));
+    if (use_fast_tier(lang_code, use_roi)) fingerprint += ";cascade;fast_model=" + hash_to_hex(model_file_hash(lang_code, true));
+    return fingerprint;
+}
+
+// 初始化结果元数据
+static OcrResult init_result(const std::string& img_path, const CsvMeta& csv_meta) {
     OcrResult res;
-    // 初始化结果元数据
+    res.line_num = csv_meta.line_num;
     res.seq_id = csv_meta.seq_id;
     res.string_id = csv_meta.string_id;
     res.screen_id = csv_meta.screen_id;
     res.part_id = csv_meta.part_id;
     res.lang = csv_meta.lang;
-    res.lang_code = LANG_CODE_MAP.at(csv_meta.lang);
+    res.lang_code = lang_code_of(csv_meta.lang_id);
     res.img_id = img_path.substr(img_path.find_last_of("/") + 1);
+    res.img_path = img_path;
     res.is_ok = false;
+    res.count = 0;
+    return res;
+}
 
-    // 检查图片文件
-    if (access(img_path.c_str(), F_OK) != 0) {
-        std::cerr << "图片不存在：" << img_path << std::endl;
-        return res;
+// 根据识别文本与置信度完成判定：比对期望文言、判断是否通过（出现次数在汇总时统计）；
+// span_marked为true时匹配片段已由调用方标出，不再重复查找
+static void judge_result(OcrResult& res, const CsvMeta& csv_meta, double confidence_threshold,
+                         bool span_marked = false) {
+    TraceScope scope(TRACE_MATCH, res.lang_code);
+    res.match_score = match_expected_text(csv_meta.lang_text, res.text, res.lang_code).score;
+    res.is_ok = (res.confidence >= confidence_threshold && res.match_score >= confidence_threshold);
+
+    // 标出与期望文言匹配的单词，识别框收窄为匹配片段的范围（标注图片与FAIL附录据此框出位置）
+    double span_score;
+    if (!span_marked && mark_matched_span(res.text_boxes, csv_meta.lang_text, res.lang_code, span_score) < 0) return;
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    for (const auto& box : res.text_boxes) {
+        if (!box.matched || box.level != OCR_BOX_WORD) continue;
+        x0 = std::min(x0, box.x);
+        y0 = std::min(y0, box.y);
+        x1 = std::max(x1, box.x + box.w);
+        y1 = std::max(y1, box.y + box.h);
+    }
+    if (x0 < x1 && y0 < y1) res.box = {x0, y0, x1 - x0, y1 - y0};
+}
+
+// 按一个层级识别：先查该层的识别结果缓存，未命中时用该层引擎识别并写回缓存；
+// image为空时在此补解码（供后续层复用）；得到识别文本返回true
+static bool recognize_tier(const DecodedImage& img, cv::Mat& image, const CsvMeta& csv_meta, OcrResult& res,
+                           bool fast, bool use_roi, const RegionRect& roi, double confidence_threshold) {
+    const std::string& img_path = img.path;
+
+    // 先查识别结果缓存：同一图片内容+语种+设置+模型直接复用上次结果（期望文言比对仍重新计算）
+    OcrCacheKey cache_key;
+    bool use_cache = make_cache_key(img, res.lang_code, use_roi ? &roi : nullptr, fast, cache_key);
+    if (use_cache) {
+        OcrCacheEntry entry;
+        bool hit;
+        {
+            TraceScope scope(TRACE_CACHE, res.lang_code);
+            hit = ocr_cache_lookup(cache_key, entry);
+        }
+        if (hit) {
+            res.text = entry.text;
+            res.confidence = entry.confidence;
+            res.box = entry.box;
+            res.text_boxes = std::move(entry.text_boxes);
+            judge_result(res, csv_meta, confidence_threshold);
+            res.tier = fast ? OCR_TIER_FAST : OCR_TIER_ACCURATE;
+            return true;
+        }
     }
 
-    // 读取图片（Leptonica）
-    PIX* pix = pixRead(img_path.c_str());
-    if (!pix) {
+    // 解码阶段因缓存预检命中而跳过了解码时，在此从保留的文件内容补解码
+    if (image.empty() && img.content_hash != 0) {
+        if (!img.bytes.empty()) {
+            image = cv::imdecode(cv::Mat(1, (int)img.bytes.size(), CV_8UC1, (void*)img.bytes.data()), cv::IMREAD_COLOR);
+        } else {
+            image = cv::imread(img_path, cv::IMREAD_COLOR);
+        }
+    }
+    if (image.empty()) {
         std::cerr << "读取图片失败：" << img_path << std::endl;
-        return res;
+        return false;
     }
 
-    std::lock_guard<std::mutex> lock(g_ocr_mutex);
-    if (!g_tess_api) {
+    if (!g_engine_ready) {
         std::cerr << "OCR引擎未初始化！" << std::endl;
-        pixDestroy(&pix);
-        return res;
+        return false;
     }
 
-    try {
-        // 切换语种
-        if (g_tess_api->Init(nullptr, res.lang_code.c_str()) != 0) {
-            std::cerr << "切换语种失败：" << res.lang_code << std::endl;
-            pixDestroy(&pix);
-            return res;
+    // 取当前线程的常驻引擎，无需全局锁，也不再每张图重新加载模型
+    tesseract::TessBaseAPI* api = acquire_thread_engine(res.lang_code, fast);
+    if (!api) {
+        return false;
+    }
+
+    cv::Mat src = image;
+    int offset_x = 0, offset_y = 0;
+    if (use_roi) {
+        int x0 = std::max(0, roi.x - ROI_PADDING);
+        int y0 = std::max(0, roi.y - ROI_PADDING);
+        int x1 = std::min(image.cols, roi.x + roi.w + ROI_PADDING);
+        int y1 = std::min(image.rows, roi.y + roi.h + ROI_PADDING);
+        if (x1 - x0 > 0 && y1 - y0 > 0) {
+            src = image(cv::Rect(x0, y0, x1 - x0, y1 - y0));
+            offset_x = x0;
+            offset_y = y0;
+        } else {
+            std::cerr << "识别区域超出图片范围，改为整页识别：" << img_path << std::endl;
+            use_roi = false;
         }
+    }
+    api->SetPageSegMode(page_seg_mode(use_roi, fast));
 
-        // 设置图片并识别
-        g_tess_api->SetImage(pix);
-        char* out_text = g_tess_api->GetUTF8Text();
+    bool recognized = false;
+    try {
+        // 预处理后直接把Mat像素缓冲区交给Tesseract，不再经过Leptonica PIX中转
+        double scale = 1.0;
+        cv::Mat prepared;
+        {
+            TraceScope scope(TRACE_PREPROCESS, res.lang_code);
+            if (g_preprocess_config.enabled) {
+                prepared = preprocess_image(src, g_preprocess_config, &scale);
+            } else {
+                // Tesseract按RGB顺序解释三通道数据
+                cv::cvtColor(src, prepared, cv::COLOR_BGR2RGB);
+            }
+        }
+        api->SetImage(prepared.data, prepared.cols, prepared.rows, prepared.channels(), (int)prepared.step[0]);
+        if (g_preprocess_config.enabled) api->SetSourceResolution(g_preprocess_config.target_dpi);
+        std::unique_ptr<char[]> out_text;
+        {
+            TraceScope scope(TRACE_RECOGNIZE, res.lang_code);
+            out_text.reset(api->GetUTF8Text());
+        }
         if (!out_text) {
             std::cerr << "识别文本为空：" << img_path << std::endl;
-            pixDestroy(&pix);
-            return res;
+            api->Clear();
+            return false;
         }
 
-        // 获取置信度
-        double avg_conf = g_tess_api->MeanTextConf() / 100.0;
-        res.text = out_text;
-        res.is_ok = (avg_conf >= confidence_threshold);
-        res.count = ++g_text_count_map[res.text];
+        // 获取置信度与行、单词框（同一遍识别结果，不再重新识别）
+        res.confidence = api->MeanTextConf() / 100.0;
+        res.text = out_text.get();
+        collect_text_boxes(api, scale, offset_x, offset_y, res.text_boxes);
+        recognized = true;
 
-        // 生成标注图片（简化版：保存原图片路径）
-        res.annotated_img = img_path;
-        res.box = {0, 0, pixGetWidth(pix), pixGetHeight(pix)};
+        res.box = {0, 0, image.cols, image.rows};
+        bool span_marked = false;
+        if (use_roi) {
+            res.box = {roi.x, roi.y, roi.w, roi.h};
+        } else if (g_learn_regions) {
+            // 学习模式：记录与目标文言最相似（不低于阈值）的文本行位置，供后续运行直接按区域识别
+            double line_score;
+            int line = mark_matched_span(res.text_boxes, csv_meta.lang_text, res.lang_code, line_score);
+            span_marked = true;
+            if (line >= 0 && line_score >= confidence_threshold) {
+                const OcrTextBox& line_box = res.text_boxes[line];
+                RegionRect line_rect;
+                line_rect.x = line_box.x;
+                line_rect.y = line_box.y;
+                line_rect.w = line_box.w;
+                line_rect.h = line_box.h;
+                res.box = {line_rect.x, line_rect.y, line_rect.w, line_rect.h};
+                std::lock_guard<std::mutex> lock(g_learn_mutex);
+                g_learned_regions[region_key(csv_meta)] = line_rect;
+            }
+        }
 
-        // 释放资源
-        delete[] out_text;
+        if (use_cache) {
+            OcrCacheEntry entry;
+            entry.text = res.text;
+            entry.confidence = res.confidence;
+            entry.box = res.box;
+            entry.text_boxes = res.text_boxes;
+            ocr_cache_store(cache_key, entry);
+        }
+
+        // 比对期望文言与识别文本（并标出匹配片段，学习模式下已标出的直接复用）
+        judge_result(res, csv_meta, confidence_threshold, span_marked);
+        res.tier = fast ? OCR_TIER_FAST : OCR_TIER_ACCURATE;
     } catch (const std::exception& e) {
         std::cerr << "处理图片异常：" << img_path << " - " << e.what() << std::endl;
+        // 不保留前一层或本层识别到一半的结果，记录按本层判定为未通过
+        res.text.clear();
+        res.confidence = 0;
+        res.match_score = 0;
+        res.is_ok = false;
+        res.box.clear();
+        res.text_boxes.clear();
+        res.tier = fast ? OCR_TIER_FAST : OCR_TIER_ACCURATE;
+        recognized = false;
     }
 
-    pixDestroy(&pix);
+    // 释放引擎内部的图片与识别结果，模型保持加载
+    api->Clear();
+    return recognized;
+}
+
+// 实现图片处理函数：开启级联时先按快速层识别，置信度与文言相似度均达到阈值即采用，
+// 否则按精确层重新识别；结果记录判定它的层级
+OcrResult process_image(const DecodedImage& img, const CsvMeta& csv_meta, double confidence_threshold) {
+    OcrResult res = init_result(img.path, csv_meta);
+    res.annotated_img = img.path;
+
+    // ROI模式：命中区域表的记录只识别对应矩形（含少量边距），按单行文本识别
+    RegionRect roi;
+    bool use_roi = find_region(g_region_map, csv_meta, roi);
+
+    cv::Mat image = img.image;
+    if (use_fast_tier(res.lang_code, use_roi)) {
+        bool recognized = recognize_tier(img, image, csv_meta, res, true, use_roi, roi, confidence_threshold);
+        if (recognized && res.is_ok) return res;
+        // 图片无法读取时精确层同样无法识别
+        if (!recognized && image.empty()) return res;
+    }
+    recognize_tier(img, image, csv_meta, res, false, use_roi, roi, confidence_threshold);
+    return res;
+}
+
+OcrResult make_failed_result(const std::string& img_path, const CsvMeta& csv_meta) {
+    OcrResult res = init_result(img_path, csv_meta);
+    res.annotated_img = img_path;
     return res;
-}
\ No newline at end of file
+}
+
+OcrResult process_image(const std::string& img_path, const CsvMeta& csv_meta, double confidence_threshold) {
+    // 检查图片文件
+    if (access(img_path.c_str(), F_OK) != 0) {
+        std::cerr << "图片不存在：" << img_path << std::endl;
+        return init_result(img_path, csv_meta);
+    }
+    return process_image(decode_image(img_path), csv_meta, confidence_threshold);
+}
@@ -0,0 +1,45 @@
+#include "ocr_scheduler.h"
+#include "ocr_processor.h"
+#include <iostream>
+#include <memory>
+
+// 当前线程上次处理的语种（仅用于日志）
+static thread_local std::string t_last_lang_code;
+
+// 语种切换时打印日志
+static void log_lang_switch(int worker_id, const std::string& lang, const std::string& lang_code) {
+    if (t_last_lang_code != lang_code) {
+        t_last_lang_code = lang_code;
+        std::cout << "线程" << worker_id << "开始处理语种：" << lang << "（编码：" << lang_code << "）" << std::endl;
+    }
+}
+
+PoolTask make_ocr_unit(std::vector<OcrJob> jobs, const std::string& lang_code, double confidence, OcrResultSink sink) {
+    std::shared_ptr<std::vector<OcrJob>> unit_jobs(new std::vector<OcrJob>(std::move(jobs)));
+
+    PoolTask unit;
+    unit.affinity = lang_code;
+    unit.weight = unit_jobs->size();
+    unit.run = [unit_jobs, lang_code, confidence, sink](int worker_id) {
+        std::vector<OcrResult> unit_results;
+        for (auto& job : *unit_jobs) {
+            log_lang_switch(worker_id, job.meta.lang, lang_code);
+            // 单张图片异常时以未通过的占位结果代替，保证每条记录都有结果（写入阶段按行号顺序等待）
+            try {
+                unit_results.push_back(process_image(job.img, job.meta, confidence));
+            } catch (const std::exception& e) {
+                std::cerr << "识别图片异常：" << job.img.path << " - " << e.what() << std::endl;
+                unit_results.push_back(make_failed_result(job.img.path, job.meta));
+            } catch (...) {
+                std::cerr << "识别图片异常：" << job.img.path << std::endl;
+                unit_results.push_back(make_failed_result(job.img.path, job.meta));
+            }
+            unit_results.back().report_image = std::move(job.report);
+            // 识别完立即释放解码后的图像与文件内容，控制内存占用（报告用图片随结果继续传递）
+            job.img.image = cv::Mat();
+            std::vector<unsigned char>().swap(job.img.bytes);
+        }
+        sink(std::move(unit_results));
+    };
+    return unit;
+}
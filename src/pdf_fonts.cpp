@@ -0,0 +1,209 @@
+#include "pdf_fonts.h"
+#include "utf8_utils.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <unistd.h>
+
+bool FontCoverage::covers(char32_t cp) const {
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), cp,
+        [](char32_t value, const std::pair<char32_t, char32_t>& range) { return value < range.first; });
+    if (it == ranges.begin()) return false;
+    --it;
+    return cp <= it->second;
+}
+
+// 大端读取
+static bool read_be(std::ifstream& in, size_t offset, size_t len, uint32_t& value) {
+    unsigned char buf[4];
+    in.seekg(offset);
+    if (!in.read((char*)buf, len)) return false;
+    value = 0;
+    for (size_t i = 0; i < len; i++) value = (value << 8) | buf[i];
+    return true;
+}
+
+bool read_font_coverage(const std::string& font_path, FontCoverage& coverage) {
+    std::ifstream in(font_path, std::ios::in | std::ios::binary);
+    if (!in) return false;
+    coverage = FontCoverage();
+
+    // TTC：取第一个字体的表目录
+    uint32_t tag, font_offset = 0, num_tables;
+    if (!read_be(in, 0, 4, tag)) return false;
+    if (tag == 0x74746366) {    // 'ttcf'
+        if (!read_be(in, 12, 4, font_offset)) return false;
+        if (!read_be(in, font_offset, 4, tag)) return false;
+    }
+    if (tag != 0x00010000 && tag != 0x74727565) return false;  // 仅支持TrueType轮廓（libharu不支持CFF）
+    if (!read_be(in, font_offset + 4, 2, num_tables)) return false;
+
+    uint32_t cmap_offset = 0, maxp_offset = 0;
+    for (uint32_t i = 0; i < num_tables; i++) {
+        size_t record = font_offset + 12 + i * 16;
+        uint32_t table_tag, table_offset;
+        if (!read_be(in, record, 4, table_tag) || !read_be(in, record + 8, 4, table_offset)) return false;
+        if (table_tag == 0x636D6170) cmap_offset = table_offset;        // 'cmap'
+        else if (table_tag == 0x6D617870) maxp_offset = table_offset;   // 'maxp'
+    }
+    if (cmap_offset == 0 || maxp_offset == 0) return false;
+
+    uint32_t glyph_num;
+    if (!read_be(in, maxp_offset + 4, 2, glyph_num)) return false;
+    coverage.glyph_num = (int)glyph_num;
+
+    // 选择Unicode子表：优先(3,10)格式12，其次(3,1)/(0,x)格式4
+    uint32_t sub_num, best_offset = 0, best_format = 0;
+    if (!read_be(in, cmap_offset + 2, 2, sub_num)) return false;
+    for (uint32_t i = 0; i < sub_num; i++) {
+        size_t record = cmap_offset + 4 + i * 8;
+        uint32_t platform, encoding, offset, format;
+        if (!read_be(in, record, 2, platform) || !read_be(in, record + 2, 2, encoding) ||
+            !read_be(in, record + 4, 4, offset) || !read_be(in, cmap_offset + offset, 2, format)) return false;
+        bool unicode = (platform == 0) || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode || (format != 4 && format != 12)) continue;
+        if (best_offset == 0 || (format == 12 && best_format != 12)) {
+            best_offset = cmap_offset + offset;
+            best_format = format;
+        }
+    }
+    if (best_offset == 0) return false;
+
+    if (best_format == 12) {
+        uint32_t group_num;
+        if (!read_be(in, best_offset + 12, 4, group_num)) return false;
+        for (uint32_t i = 0; i < group_num; i++) {
+            uint32_t start, end;
+            if (!read_be(in, best_offset + 16 + i * 12, 4, start) ||
+                !read_be(in, best_offset + 20 + i * 12, 4, end)) return false;
+            coverage.ranges.emplace_back(start, end);
+        }
+    } else {
+        uint32_t seg_x2;
+        if (!read_be(in, best_offset + 6, 2, seg_x2)) return false;
+        size_t end_codes = best_offset + 14;
+        size_t start_codes = end_codes + seg_x2 + 2;
+        for (uint32_t i = 0; i < seg_x2 / 2; i++) {
+            uint32_t start, end;
+            if (!read_be(in, start_codes + i * 2, 2, start) || !read_be(in, end_codes + i * 2, 2, end)) return false;
+            if (start == 0xFFFF) continue;
+            coverage.ranges.emplace_back(start, end);
+        }
+    }
+    std::sort(coverage.ranges.begin(), coverage.ranges.end());
+    return !coverage.ranges.empty();
+}
+
+std::vector<std::string> default_report_fonts(const std::string& tessdata_dir) {
+    std::vector<std::string> fonts;
+    if (!tessdata_dir.empty()) fonts.push_back(tessdata_dir + "/pdf.ttf");
+    const char* system_fonts[] = {
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/noto/NotoSans-Regular.ttf",
+        "/usr/share/fonts/truetype/noto/NotoSansThai-Regular.ttf",
+        "/usr/share/fonts/truetype/noto/NotoSansArabic-Regular.ttf",
+        "/usr/share/fonts/truetype/freefont/FreeSans.ttf",
+        "/usr/share/fonts/truetype/tlwg/Garuda.ttf",
+        "/usr/share/fonts/truetype/wqy/wqy-microhei.ttc",
+        "/usr/share/fonts/truetype/wqy/wqy-zenhei.ttc",
+        "/usr/share/fonts/truetype/droid/DroidSansFallbackFull.ttf",
+        "/usr/share/fonts/truetype/arphic/uming.ttc",
+    };
+    for (const char* path : system_fonts) fonts.push_back(path);
+    return fonts;
+}
+
+PdfFontSet::PdfFontSet() : m_pdf(nullptr), m_fallback(nullptr) {}
+
+void PdfFontSet::init(HPDF_Doc pdf, const std::vector<std::string>& font_paths) {
+    m_pdf = pdf;
+    m_candidates.clear();
+    m_used.clear();
+    m_missing.clear();
+    HPDF_UseUTFEncodings(pdf);
+
+    for (const auto& path : font_paths) {
+        if (access(path.c_str(), R_OK) != 0) continue;
+        Candidate candidate;
+        candidate.path = path;
+        if (!read_font_coverage(path, candidate.coverage)) {
+            std::cerr << "无法解析字体（需为TrueType轮廓）：" << path << std::endl;
+            continue;
+        }
+        // Tesseract自带的pdf.ttf是仅供隐藏文字层使用的空白字体，所有字符都映射到空字形
+        if (candidate.coverage.glyph_num < 3) {
+            std::cerr << "跳过无可见字形的字体：" << path << std::endl;
+            continue;
+        }
+        m_candidates.push_back(std::move(candidate));
+    }
+
+    m_fallback = HPDF_GetFont(pdf, "Helvetica", nullptr);
+    if (m_candidates.empty()) {
+        std::cerr << "未找到可嵌入的Unicode字体，非拉丁文字将无法正确显示！" << std::endl;
+    }
+}
+
+HPDF_Font PdfFontSet::load(Candidate& candidate) {
+    if (candidate.font || candidate.load_failed) return candidate.font;
+
+    const char* name = nullptr;
+    const std::string& path = candidate.path;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".ttc") == 0) {
+        name = HPDF_LoadTTFontFromFile2(m_pdf, path.c_str(), 0, HPDF_TRUE);
+    } else {
+        name = HPDF_LoadTTFontFromFile(m_pdf, path.c_str(), HPDF_TRUE);
+    }
+    if (name) candidate.font = HPDF_GetFont(m_pdf, name, "UTF-8");
+    if (!candidate.font) {
+        std::cerr << "字体加载失败：" << path << std::endl;
+        candidate.load_failed = true;
+    }
+    return candidate.font;
+}
+
+HPDF_Font PdfFontSet::font_for(const std::string& text) {
+    std::vector<char32_t> cps;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        char32_t cp = utf8_next(text, pos);
+        if (cp < 0x20 || is_format_cp(cp)) continue;
+        cps.push_back(cp);
+        m_used.insert(cp);
+    }
+
+    // 第一个完整覆盖的字体；都不能完整覆盖时取覆盖字符最多的
+    Candidate* best = nullptr;
+    size_t best_covered = 0;
+    for (auto& candidate : m_candidates) {
+        if (candidate.load_failed) continue;
+        size_t covered = 0;
+        for (char32_t cp : cps) covered += candidate.coverage.covers(cp);
+        if (covered == cps.size()) {
+            best = &candidate;
+            best_covered = covered;
+            break;
+        }
+        if (!best || covered > best_covered) {
+            best = &candidate;
+            best_covered = covered;
+        }
+    }
+
+    if (best_covered < cps.size()) {
+        for (char32_t cp : cps) {
+            if (!best || !best->coverage.covers(cp)) m_missing.insert(cp);
+        }
+    }
+    HPDF_Font font = best ? load(*best) : nullptr;
+    return font ? font : m_fallback;
+}
+
+std::vector<std::string> PdfFontSet::loaded_fonts() const {
+    std::vector<std::string> fonts;
+    for (const auto& candidate : m_candidates) {
+        if (candidate.font) fonts.push_back(candidate.path);
+    }
+    return fonts;
+}
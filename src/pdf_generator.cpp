@@ -5,7 +5,10 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <cstdio>
 #include "data_struct.h"
+#include "pdf_fonts.h"
+#include <opencv2/opencv.hpp>
 
 // 递归创建目录
 bool create_dir(const std::string& dir_path) {
@@ -30,17 +33,6 @@ void pdf_error_handler(HPDF_STATUS error_no, HPDF_STATUS detail_no, void* user_d
     std::cerr << "PDF错误：" << error_no << ", " << detail_no << std::endl;
 }
 
-// 加载多语种字体（适配特殊字符）
-HPDF_Font load_multilang_font(HPDF_Doc pdf) {
-    // 优先加载系统通用字体（支持多语种）
-    HPDF_Font font = HPDF_GetFont(pdf, "Helvetica", "UTF-8");
-    if (!font) {
-        font = HPDF_GetFont(pdf, "Courier", "UTF-8");
-    }
-
-    return font;
-}
-
 // 适配新版libharu的图片加载函数（支持PNG）
 HPDF_Image load_image_to_pdf(HPDF_Doc pdf, const std::string& img_path) {
     // 判断文件是否为PNG格式（仅支持PNG，适配项目需求）
@@ -58,11 +50,117 @@ HPDF_Image load_image_to_pdf(HPDF_Doc pdf, const std::string& img_path) {
     
 }
 
-// 生成PDF报告（适配多语种）
-bool generate_pdf(
-    const std::string& pdf_path,
-    const std::vector<OcrResult>& all_results
-) {
+// 表格版式（横向A4）：缩略图 + 9列（序号/StringID/ScreenID/PartID/语种/图片ID/文言/识别状态/出现次数）
+static const float PAGE_MARGIN = 20;
+static const float HEADER_HEIGHT = 22;
+static const float TABLE_FONT_SIZE = 9;
+static const int TABLE_COLS = 10;
+static const float COL_WIDTHS[TABLE_COLS] = {90, 50, 80, 80, 80, 50, 100, 150, 70, 50};
+static const char* COL_HEADERS[TABLE_COLS] = {
+    "图片", "序号", "String ID", "ScreenID", "PartID",
+    "语种", "图片ID", "文言内容", "识别状态", "出现次数"
+};
+
+// 缩小为缩略图（RGB）
+static cv::Mat make_thumbnail(const cv::Mat& img, int max_side) {
+    cv::Mat small = img;
+    double scale = std::min(1.0, (double)max_side / std::max(img.cols, img.rows));
+    if (scale < 1.0) {
+        cv::resize(img, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    cv::Mat rgb;
+    cv::cvtColor(small, rgb, cv::COLOR_BGR2RGB);
+    return rgb;
+}
+
+// 以原始RGB数据嵌入（开启压缩后按Flate压缩存储）
+static HPDF_Image load_rgb_to_pdf(HPDF_Doc pdf, cv::Mat rgb) {
+    if (!rgb.isContinuous()) rgb = rgb.clone();
+    return HPDF_LoadRawImageFromMem(pdf, rgb.data, rgb.cols, rgb.rows, HPDF_CS_DEVICE_RGB, 8);
+}
+
+// 从文件生成缩略图：缩小后以原始RGB数据嵌入（开启压缩后体积远小于原图）
+static HPDF_Image load_thumbnail_to_pdf(HPDF_Doc pdf, const std::string& img_path, int max_side, cv::Size* size) {
+    cv::Mat img = cv::imread(img_path, cv::IMREAD_COLOR);
+    if (img.empty()) return nullptr;
+    *size = img.size();
+    return load_rgb_to_pdf(pdf, make_thumbnail(img, max_side));
+}
+
+static bool is_jpeg_path(const std::string& img_path) {
+    std::string ext = img_path.substr(img_path.find_last_of(".") + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == "jpg" || ext == "jpeg";
+}
+
+std::shared_ptr<const ReportImage> make_report_image(const std::string& img_path, const cv::Mat& image,
+                                                     const ReportLayout& layout, bool keep_source) {
+    std::shared_ptr<ReportImage> report(new ReportImage());
+    if (keep_source) report->source = image;
+    report->width = image.cols;
+    report->height = image.rows;
+    if (image.empty() || layout.image_mode == REPORT_IMAGE_NONE) return report;
+    if (layout.image_mode == REPORT_IMAGE_THUMB) report->thumb = make_thumbnail(image, layout.thumb_max_side);
+    // JPEG原图按文件数据直接嵌入（无需解码），其余格式共用识别用的解码结果
+    if (!is_jpeg_path(img_path)) report->full = image;
+    return report;
+}
+
+// 按列宽截断文本（按UTF-8字符截断，超出部分以...结尾）
+static std::string fit_text(HPDF_Page page, const std::string& text, float width) {
+    if (HPDF_Page_TextWidth(page, text.c_str()) <= width) return text;
+    std::string fitted = text;
+    while (!fitted.empty()) {
+        // 去掉最后一个UTF-8字符
+        size_t cut = fitted.size() - 1;
+        while (cut > 0 && ((unsigned char)fitted[cut] & 0xC0) == 0x80) cut--;
+        fitted.erase(cut);
+        if (HPDF_Page_TextWidth(page, (fitted + "...").c_str()) <= width) break;
+    }
+    return fitted + "...";
+}
+
+// 在矩形内等比缩放居中绘制图片，placed返回实际绘制区域（左下角x、y与宽、高）
+static bool draw_image_fit(HPDF_Page page, HPDF_Image img, float x, float y, float w, float h, float placed[4]) {
+    float img_w = HPDF_Image_GetWidth(img);
+    float img_h = HPDF_Image_GetHeight(img);
+    if (img_w <= 0 || img_h <= 0) return false;
+    float scale = std::min(w / img_w, h / img_h);
+    placed[2] = img_w * scale;
+    placed[3] = img_h * scale;
+    placed[0] = x + (w - placed[2]) / 2;
+    placed[1] = y + (h - placed[3]) / 2;
+    HPDF_Page_DrawImage(page, img, placed[0], placed[1], placed[2], placed[3]);
+    return true;
+}
+
+// 在已绘制的图片上叠加识别位置框（原图坐标，通过绿色、未通过红色）；框为整张图片时不绘制
+static void draw_box_overlay(HPDF_Page page, const OcrResult& res, const float placed[4], cv::Size src_size) {
+    if (res.box.size() < 4 || res.box[2] <= 0 || res.box[3] <= 0) return;
+    if (src_size.width <= 0 || src_size.height <= 0) return;
+    if (res.box[0] <= 0 && res.box[1] <= 0 && res.box[2] >= src_size.width && res.box[3] >= src_size.height) return;
+    float sx = placed[2] / src_size.width;
+    float sy = placed[3] / src_size.height;
+    if (res.is_ok) {
+        HPDF_Page_SetRGBStroke(page, 0, 0.7, 0);
+    } else {
+        HPDF_Page_SetRGBStroke(page, 1, 0, 0);
+    }
+    HPDF_Page_SetLineWidth(page, 1);
+    HPDF_Page_Rectangle(page, placed[0] + res.box[0] * sx, placed[1] + placed[3] - (res.box[1] + res.box[3]) * sy,
+                        res.box[2] * sx, res.box[3] * sy);
+    HPDF_Page_Stroke(page);
+    HPDF_Page_SetRGBStroke(page, 0, 0, 0);
+    HPDF_Page_SetLineWidth(page, 0.5);
+}
+
+PdfReportWriter::PdfReportWriter() : m_pdf(nullptr), m_pages(0), m_page(nullptr), m_row_y(0) {}
+
+PdfReportWriter::~PdfReportWriter() {
+    if (m_pdf) HPDF_Free(m_pdf);
+}
+
+bool PdfReportWriter::open(const std::string& pdf_path, const ReportLayout& layout) {
     // 创建PDF输出目录
     size_t pos = pdf_path.find_last_of("/");
     if (pos != std::string::npos) {
@@ -70,97 +168,255 @@ bool generate_pdf(
     }
 
     // 初始化PDF文档（UTF-8编码）
-    HPDF_Doc pdf = HPDF_New(pdf_error_handler, nullptr);
-    if (!pdf) {
+    m_pdf = HPDF_New(pdf_error_handler, nullptr);
+    if (!m_pdf) {
         std::cerr << "PDF文档创建失败！" << std::endl;
         return false;
     }
+    m_path = pdf_path;
+    m_pages = 0;
+    m_layout = layout;
+    m_page = nullptr;
+    m_thumbs.clear();
+    m_images.clear();
+    m_fail_order.clear();
+    m_fail_marks.clear();
+
+    // 页面内容与缩略图数据压缩存储
+    HPDF_SetCompressionMode(m_pdf, HPDF_COMP_ALL);
+
+    // 多语种字体：启用UTF-8编码，候选TrueType字体在首次用到时加载一次并嵌入（只保留用到的字形）
+    m_fonts.init(m_pdf, layout.font_paths.empty() ? default_report_fonts("") : layout.font_paths);
+    HPDF_SetCurrentEncoder(m_pdf, "UTF-8");
+    return true;
+}
+
+// 按文本内容选择字体（同时记录用到的字符）
+void PdfReportWriter::set_font(HPDF_Page page, const std::string& text, float size) {
+    HPDF_Page_SetFontAndSize(page, m_fonts.font_for(text), size);
+}
+
+void PdfReportWriter::draw_text(HPDF_Page page, float x, float y, const std::string& text, float size) {
+    set_font(page, text, size);
+    HPDF_Page_BeginText(page);
+    HPDF_Page_TextOut(page, x, y, text.c_str());
+    HPDF_Page_EndText(page);
+}
 
-    // 设置PDF全局编码为UTF-8
-    HPDF_SetCurrentEncoder(pdf, "UTF-8");
+// 新建表格页并绘制表头
+HPDF_Page PdfReportWriter::new_table_page() {
+    HPDF_Page page = HPDF_AddPage(m_pdf);
+    HPDF_Page_SetSize(page, HPDF_PAGE_SIZE_A4, HPDF_PAGE_LANDSCAPE); // 横向A4（适配多列）
+    HPDF_Page_SetRGBFill(page, 0, 0, 0);
+    HPDF_Page_SetLineWidth(page, 0.5);
+    m_pages++;
 
-    // 加载多语种字体
-    HPDF_Font font = load_multilang_font(pdf);
-    if (!font) {
-        std::cerr << "加载多语种字体失败，使用默认字体！" << std::endl;
-        font = HPDF_GetFont(pdf, "Helvetica", nullptr);
+    float x = PAGE_MARGIN;
+    float y = HPDF_Page_GetHeight(page) - PAGE_MARGIN - HEADER_HEIGHT;
+    for (int i = 0; i < TABLE_COLS; i++) {
+        HPDF_Page_Rectangle(page, x, y, COL_WIDTHS[i], HEADER_HEIGHT);
+        HPDF_Page_Stroke(page);
+        draw_text(page, x + 4, y + 7, COL_HEADERS[i], TABLE_FONT_SIZE);
+        x += COL_WIDTHS[i];
     }
+    m_page = page;
+    m_row_y = y;
+    return page;
+}
 
-    // 遍历结果生成PDF页面
-    for (const auto& res : all_results) {
-        HPDF_Page page = HPDF_AddPage(pdf);
-        HPDF_Page_SetSize(page, HPDF_PAGE_SIZE_A4, HPDF_PAGE_LANDSCAPE); // 横向A4（适配多列）
-        HPDF_Page_SetFontAndSize(page, font, 10); // 缩小字体适配多列
-
-        // 1. 插入标注图片（适配新版libharu）
-        if (access(res.annotated_img.c_str(), F_OK) == 0) {
-            HPDF_Image img = load_image_to_pdf(pdf, res.annotated_img); // 替换为适配函数
-            if (img) {
-                float img_w = HPDF_Image_GetWidth(img);
-                float img_h = HPDF_Image_GetHeight(img);
-                float page_w = HPDF_Page_GetWidth(page) - 40;
-                float scale = page_w / img_w;
-                float draw_h = img_h * scale;
-                float draw_y = HPDF_Page_GetHeight(page) - draw_h - 150;
-                HPDF_Page_DrawImage(page, img, 20, draw_y, page_w, draw_h);
-            }
-        }
+// 同一图片只加载一次（缩略图与原图分别缓存）；有解码阶段生成的图片时直接使用，不再读取文件
+HPDF_Image PdfReportWriter::get_image(const std::string& img_path, bool thumbnail, const ReportImage* src) {
+    std::map<std::string, HPDF_Image>& cache = thumbnail ? m_thumbs : m_images;
+    auto it = cache.find(img_path);
+    if (it != cache.end()) return it->second;
 
-        // 2. 绘制扩展表格（9列：序号/StringID/ScreenID/PartID/语种/图片ID/文言/识别状态/出现次数）
-        const float col_widths[9] = {50, 80, 80, 80, 50, 100, 120, 60, 50}; // 适配横向A4
-        const float row_height = 25;
-        float table_x = 20;
-        float table_y = HPDF_Page_GetHeight(page) - 170;
-
-        // 表格标题
-        std::string headers[9] = {
-            "序号", "String ID", "ScreenID", "PartID", 
-            "语种", "图片ID", "文言内容", "识别状态", "出现次数"
-        };
-        HPDF_Page_SetRGBFill(page, 0, 0, 0);
-        for (int i = 0; i < 9; i++) {
-            HPDF_Page_Rectangle(page, table_x, table_y, col_widths[i], row_height);
-            HPDF_Page_Stroke(page);
+    HPDF_Image img = nullptr;
+    cv::Size size;
+    if (src && thumbnail && !src->thumb.empty()) {
+        img = load_rgb_to_pdf(m_pdf, src->thumb);
+        size = cv::Size(src->width, src->height);
+    } else if (src && !thumbnail && !src->full.empty()) {
+        cv::Mat rgb;
+        cv::cvtColor(src->full, rgb, cv::COLOR_BGR2RGB);
+        img = load_rgb_to_pdf(m_pdf, rgb);
+    } else if (access(img_path.c_str(), F_OK) == 0) {
+        img = thumbnail ? load_thumbnail_to_pdf(m_pdf, img_path, m_layout.thumb_max_side, &size)
+                        : load_image_to_pdf(m_pdf, img_path);
+    }
+    // 原图嵌入时图片尺寸即原图尺寸，缩略图另行记录
+    if (img && !thumbnail) size = cv::Size((int)HPDF_Image_GetWidth(img), (int)HPDF_Image_GetHeight(img));
+    if (img && size.width > 0 && m_image_sizes.find(img_path) == m_image_sizes.end()) m_image_sizes[img_path] = size;
+    cache[img_path] = img;  // 加载失败也记录，避免重复尝试
+    return img;
+}
+
+// 追加一行（当前页放不下时换页，结果到达即写入）
+bool PdfReportWriter::add_result(const OcrResult& res) {
+    if (!m_pdf) return false;
+
+    float row_height = m_layout.row_height;
+    if (!m_page || m_row_y - row_height < PAGE_MARGIN) new_table_page();
+    HPDF_Page page = m_page;
+    m_row_y -= row_height;
+    float y = m_row_y;
+    float text_y = y + row_height / 2 - 3;
+
+    char score_buf[16];
+    snprintf(score_buf, sizeof(score_buf), " %.2f", res.match_score);
+    std::string status = std::string(res.is_ok ? "OK" : "FAIL") + score_buf;
+    if (res.tier == OCR_TIER_FAST) {
+        status += " 快速";
+    } else if (res.tier == OCR_TIER_ACCURATE) {
+        status += " 精确";
+    }
+    std::string data[TABLE_COLS] = {
+        "", res.seq_id, res.string_id, res.screen_id, res.part_id,
+        res.lang, res.img_id, res.text, status, std::to_string(res.count)
+    };
+
+    float x = PAGE_MARGIN;
+    for (int i = 0; i < TABLE_COLS; i++) {
+        float width = COL_WIDTHS[i];
+        HPDF_Page_Rectangle(page, x, y, width, row_height);
+        HPDF_Page_Stroke(page);
+
+        if (i == 0) {
+            // 图片列：缩略图或原图（同一图片多行共用一个图片对象），本行的识别位置以矢量框叠加
+            if (m_layout.image_mode != REPORT_IMAGE_NONE) {
+                const std::string& img_path = res.img_path.empty() ? res.annotated_img : res.img_path;
+                HPDF_Image img = get_image(img_path, m_layout.image_mode == REPORT_IMAGE_THUMB,
+                                           res.report_image.get());
+                float placed[4];
+                if (img && draw_image_fit(page, img, x + 2, y + 2, width - 4, row_height - 4, placed)) {
+                    auto size_it = m_image_sizes.find(img_path);
+                    if (size_it != m_image_sizes.end()) draw_box_overlay(page, res, placed, size_it->second);
+                }
+            }
+        } else if (i == TABLE_COLS - 1) {
+            // 出现次数需等全部结果汇总后才能确定，保存前再补写
+            m_count_cells.push_back({page, x + 4, text_y, res.text, res.count});
+        } else {
+            set_font(page, data[i], TABLE_FONT_SIZE);
+            std::string text = fit_text(page, data[i], width - 8);
+            float text_x = x + 4;
+            // 阿拉伯语文本右对齐（文言内容列）
+            if (res.lang_code == "ara" && i == 7) {
+                text_x = x + width - 4 - HPDF_Page_TextWidth(page, text.c_str());
+            }
             HPDF_Page_BeginText(page);
-            HPDF_Page_TextOut(page, table_x + 5, table_y + 8, headers[i].c_str());
+            HPDF_Page_TextOut(page, text_x, text_y, text.c_str());
             HPDF_Page_EndText(page);
-            table_x += col_widths[i];
         }
+        x += width;
+    }
 
-        // 表格数据
-        table_x = 20;
-        table_y -= row_height;
-        std::string status = res.is_ok ? "OK" : "FAIL";
-        std::string data[9] = {
-            res.seq_id, res.string_id, res.screen_id, res.part_id,
-            res.lang, res.img_id, res.text, status, std::to_string(res.count)
-        };
-
-        // 适配右对齐语言（阿拉伯语）
-        for (int i = 0; i < 9; i++) {
-            HPDF_Page_Rectangle(page, table_x, table_y, col_widths[i], row_height);
+    // 缩略图模式下FAIL记录的原图附在报告末尾（同一原图只附一次，识别位置为原图坐标）
+    const std::string& src_path = res.img_path.empty() ? res.annotated_img : res.img_path;
+    if (!res.is_ok && m_layout.image_mode == REPORT_IMAGE_THUMB && !src_path.empty()) {
+        std::vector<FailMark>& marks = m_fail_marks[src_path];
+        if (marks.empty()) {
+            m_fail_order.push_back(src_path);
+            // 原图对象现在就用随结果到达的解码图像创建，保存时直接绘制附录页
+            get_image(src_path, false, res.report_image.get());
+        }
+        marks.push_back({res.string_id, res.box});
+    }
+    return true;
+}
+
+// FAIL原图页：每张图片一页，按原始分辨率嵌入并框出各FAIL记录的识别位置
+void PdfReportWriter::add_fail_pages() {
+    for (const auto& img_path : m_fail_order) {
+        HPDF_Image img = get_image(img_path, false, nullptr);
+        if (!img) continue;
+
+        HPDF_Page page = HPDF_AddPage(m_pdf);
+        HPDF_Page_SetSize(page, HPDF_PAGE_SIZE_A4, HPDF_PAGE_LANDSCAPE);
+        m_pages++;
+
+        const std::vector<FailMark>& marks = m_fail_marks[img_path];
+        std::string title = "FAIL: " + img_path.substr(img_path.find_last_of("/") + 1) + "  String ID:";
+        for (const auto& mark : marks) title += " " + mark.string_id;
+        float page_w = HPDF_Page_GetWidth(page);
+        float page_h = HPDF_Page_GetHeight(page);
+        HPDF_Page_SetRGBFill(page, 0, 0, 0);
+        set_font(page, title, 10);
+        draw_text(page, PAGE_MARGIN, page_h - PAGE_MARGIN - 10, fit_text(page, title, page_w - 2 * PAGE_MARGIN), 10);
+
+        // 图片按页面可用区域等比缩放（PDF中缩放不损失原图分辨率）
+        float area_w = page_w - 2 * PAGE_MARGIN;
+        float area_h = page_h - 2 * PAGE_MARGIN - 24;
+        float img_w = HPDF_Image_GetWidth(img);
+        float img_h = HPDF_Image_GetHeight(img);
+        if (img_w <= 0 || img_h <= 0) continue;
+        float scale = std::min(area_w / img_w, area_h / img_h);
+        float origin_x = PAGE_MARGIN;
+        float origin_y = PAGE_MARGIN + area_h - img_h * scale;
+        HPDF_Page_DrawImage(page, img, origin_x, origin_y, img_w * scale, img_h * scale);
+
+        HPDF_Page_SetRGBStroke(page, 1, 0, 0);
+        HPDF_Page_SetLineWidth(page, 1.5);
+        for (const auto& mark : marks) {
+            if (mark.box.size() < 4 || mark.box[2] <= 0 || mark.box[3] <= 0) continue;
+            float bx = origin_x + mark.box[0] * scale;
+            float by = origin_y + (img_h - mark.box[1] - mark.box[3]) * scale;
+            HPDF_Page_Rectangle(page, bx, by, mark.box[2] * scale, mark.box[3] * scale);
             HPDF_Page_Stroke(page);
-            HPDF_Page_BeginText(page);
-            
-            float text_x = table_x + 5;
-            // 阿拉伯语文本右对齐（文言内容列）
-            if (res.lang_code == "ara" && i == 6) {
-                text_x = table_x + col_widths[i] - data[i].size()*8 - 5;
-            }
-            
-            HPDF_Page_TextOut(page, text_x, table_y + 8, data[i].c_str());
-            HPDF_Page_EndText(page);
-            table_x += col_widths[i];
         }
     }
+}
+
+void PdfReportWriter::set_text_counts(const std::map<std::string, int>& counts) {
+    m_text_counts = counts;
+}
+
+bool PdfReportWriter::close() {
+    if (!m_pdf) return false;
+
+    // 补写出现次数（未设置最终计数时使用结果自带的值）
+    for (const auto& cell : m_count_cells) {
+        auto it = m_text_counts.find(cell.text);
+        int count = (it != m_text_counts.end()) ? it->second : cell.count;
+        draw_text(cell.page, cell.x, cell.y, std::to_string(count), TABLE_FONT_SIZE);
+    }
+    m_count_cells.clear();
+
+    add_fail_pages();
 
     // 保存PDF
-    if (HPDF_SaveToFile(pdf, pdf_path.c_str()) != HPDF_OK) {
+    bool ok = true;
+    if (HPDF_SaveToFile(m_pdf, m_path.c_str()) != HPDF_OK) {
         std::cerr << "PDF保存失败！" << std::endl;
-        HPDF_Free(pdf);
-        return false;
+        ok = false;
     }
 
-    HPDF_Free(pdf);
-    return true;
-}
\ No newline at end of file
+    HPDF_Free(m_pdf);
+    m_pdf = nullptr;
+    size_t image_num = 0;
+    for (const auto& item : m_thumbs) image_num += (item.second != nullptr);
+    for (const auto& item : m_images) image_num += (item.second != nullptr);
+    std::cout << "PDF报告：" << m_pages << "页，嵌入图片" << image_num << "个" << std::endl;
+    std::cout << "PDF字体：";
+    for (const auto& font : m_fonts.loaded_fonts()) std::cout << font << " ";
+    std::cout << "（用到" << m_fonts.used_char_count() << "个字符，缺字" << m_fonts.missing_char_count() << "个）" << std::endl;
+    return ok;
+}
+
+// 生成PDF报告（适配多语种）
+bool generate_pdf(
+    const std::string& pdf_path,
+    const std::vector<OcrResult>& all_results
+) {
+    PdfReportWriter writer;
+    if (!writer.open(pdf_path)) return false;
+
+    std::map<std::string, int> counts;
+    for (const auto& res : all_results) counts[res.text]++;
+    writer.set_text_counts(counts);
+
+    // 遍历结果生成PDF页面
+    for (const auto& res : all_results) {
+        writer.add_result(res);
+    }
+    return writer.close();
+}
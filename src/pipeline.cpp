@@ -0,0 +1,356 @@
+#include "pipeline.h"
+#include "bounded_queue.h"
+#include "csv_parser.h"
+#include "ocr_scheduler.h"
+#include "pdf_generator.h"
+#include "ocr_processor.h"
+#include "text_counter.h"
+#include "trace.h"
+#include "shard.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <mutex>
+
+// 结果后续只需缩略图（keep_full为false）或已完成标注时，换成不持有多余像素的报告用图片
+static void release_report_pixels(OcrResult& res, bool keep_full) {
+    const ReportImage* report = res.report_image.get();
+    if (!report || (report->source.empty() && (keep_full || report->full.empty()))) return;
+    std::shared_ptr<ReportImage> slim(new ReportImage());
+    slim->thumb = report->thumb;
+    if (keep_full) slim->full = report->full;
+    slim->width = report->width;
+    slim->height = report->height;
+    res.report_image = slim;
+}
+
+bool run_pipeline(const PipelineConfig& config, const ImageIndex& img_index, ThreadPool& pool, PipelineStats& stats) {
+    stats = PipelineStats();
+
+    PdfReportWriter writer;
+    bool with_report = !config.pdf_output.empty();
+    if (with_report && !writer.open(config.pdf_output, config.report_layout)) return false;
+
+    size_t capacity = config.queue_capacity;
+    BoundedQueue<CsvMeta> row_queue(capacity);
+    BoundedQueue<std::pair<std::string, CsvMeta>> resolved_queue(capacity);
+    BoundedQueue<OcrJob> decoded_queue(capacity);
+    BoundedQueue<std::vector<OcrResult>> render_queue(capacity);
+    BoundedQueue<std::vector<OcrResult>> result_queue(capacity);
+    bool csv_ok = true;
+
+    // 本次运行清单（查找、解码、写入阶段分别填写图片快照、图片哈希与识别结果）
+    RunManifest manifest;
+    std::mutex manifest_mutex;
+    bool track = (config.manifest_out != nullptr || config.prev_manifest != nullptr || config.journal != nullptr);
+
+    // 文本出现次数：识别线程分片计数，结束后合并
+    TextCounter text_counts;
+
+    // 报告按CSV行号顺序写入：查找阶段按顺序登记会产生结果的行号，写入阶段据此重排
+    std::deque<int> result_order;
+    std::mutex order_mutex;
+    auto expect_result = [&](int line_num) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        result_order.push_back(line_num);
+    };
+
+    // 1. 读取阶段：逐条解析CSV记录
+    std::thread reader([&]() {
+        trace_thread_name("csv-reader");
+        try {
+            auto on_row = [&](CsvMeta& meta) {
+                if (config.shard_count > 1 && shard_of(meta, config.shard_count) != config.shard_index) return;
+                stats.rows++;
+                row_queue.push(std::move(meta));
+            };
+            if (!config.csv_text.empty()) {
+                parse_csv_data(config.csv_text, on_row);
+            } else {
+                parse_csv_rows(config.csv_path, on_row);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "CSV解析失败：" << e.what() << std::endl;
+            csv_ok = false;
+        }
+        row_queue.close();
+    });
+
+    // 2. 查找阶段：按String ID在目录索引中查找图片
+    std::thread resolver([&]() {
+        trace_thread_name("resolver");
+        CsvMeta meta;
+        while (row_queue.pop(meta)) {
+            std::string img_path;
+            {
+                TraceScope scope(TRACE_LOOKUP, lang_code_of(meta.lang_id));
+                img_path = match_image_by_string_id(img_index, meta.string_id);
+            }
+            if (img_path.empty()) {
+                std::cerr << "未找到String ID[" << meta.string_id << "]对应的图片，跳过！" << std::endl;
+                stats.missing_images++;
+                continue;
+            }
+            if (track) {
+                std::string key = manifest_row_key(meta);
+                ManifestEntry entry;
+                entry.row_hash = manifest_row_hash(meta, ocr_settings_fingerprint(meta), config.confidence);
+                stat_image_file(img_path, entry);
+
+                // 增量模式：文言、元数据、设置与图片均未变化，直接复用上次结果
+                if (config.prev_manifest) {
+                    auto prev_it = config.prev_manifest->rows.find(key);
+                    if (prev_it != config.prev_manifest->rows.end() && manifest_entry_unchanged(prev_it->second, entry)) {
+                        {
+                            std::lock_guard<std::mutex> lock(manifest_mutex);
+                            manifest.rows[key] = prev_it->second;
+                        }
+                        stats.reused++;
+                        OcrResult res = prev_it->second.result;
+                        res.line_num = meta.line_num;
+                        text_counts.add(res.text);
+                        expect_result(meta.line_num);
+                        result_queue.push(std::vector<OcrResult>(1, std::move(res)));
+                        continue;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(manifest_mutex);
+                manifest.rows[key] = entry;
+            }
+            expect_result(meta.line_num);
+            // 入队即预读，解码线程读取时文件已在页缓存中（预读量受队列容量限制）
+            prefetch_image_file(img_path);
+            resolved_queue.push(std::make_pair(img_path, std::move(meta)));
+        }
+        resolved_queue.close();
+    });
+
+    // 报告用图片：每张图片只解码一次，同一图片的多条记录共用解码阶段生成的同一份（写入报告后释放）
+    bool report_images = with_report && config.report_layout.image_mode != REPORT_IMAGE_NONE;
+    bool annotate = !config.annotate.out_dir.empty() && create_dir(config.annotate.out_dir);
+    ReportLayout report_layout = config.report_layout;
+    if (!report_images) report_layout.image_mode = REPORT_IMAGE_NONE;
+    std::map<std::string, std::weak_ptr<const ReportImage>> report_image_map;
+    std::mutex report_image_mutex;
+    auto attach_report_image = [&](OcrJob& job) {
+        {
+            std::lock_guard<std::mutex> lock(report_image_mutex);
+            auto it = report_image_map.find(job.img.path);
+            if (it != report_image_map.end()) job.report = it->second.lock();
+        }
+        if (job.report) return;
+        // 识别结果已缓存而跳过解码的图片，报告仍需要像素，从保留的文件内容解码
+        if (!ensure_image_decoded(job.img)) return;
+        // 报告按原图嵌入（同一图片只生成一次）；标注时另保留解码图像供绘制线程使用
+        job.report = make_report_image(job.img.path, job.img.image, report_layout, annotate);
+        std::lock_guard<std::mutex> lock(report_image_mutex);
+        if (report_image_map.size() >= capacity * 4) {
+            for (auto it = report_image_map.begin(); it != report_image_map.end();) {
+                it = it->second.expired() ? report_image_map.erase(it) : std::next(it);
+            }
+        }
+        report_image_map[job.img.path] = job.report;
+    };
+
+    // 3. 解码阶段：多个线程并行读取并解码图片（识别结果已缓存的图片只读取不解码），同时生成报告用图片
+    int decode_threads = std::max(1, config.decode_threads);
+    std::atomic<int> decoders_left(decode_threads);
+    std::vector<std::thread> decoders;
+    for (int i = 0; i < decode_threads; i++) {
+        decoders.emplace_back([&, i]() {
+            trace_thread_name("decoder-" + std::to_string(i));
+            std::pair<std::string, CsvMeta> item;
+            while (resolved_queue.pop(item)) {
+                OcrJob job;
+                {
+                    TraceScope scope(TRACE_DECODE, lang_code_of(item.second.lang_id));
+                    job.img = load_image_for_ocr(item.first, item.second);
+                    if (report_images || annotate) attach_report_image(job);
+                }
+                if (track) {
+                    std::lock_guard<std::mutex> lock(manifest_mutex);
+                    manifest.rows[manifest_row_key(item.second)].img_hash = job.img.content_hash;
+                }
+                job.meta = std::move(item.second);
+                decoded_queue.push(std::move(job));
+            }
+            if (--decoders_left == 0) decoded_queue.close();
+        });
+    }
+
+    // 5. 写入阶段：结果到达后按CSV行号顺序生成PDF页面（先到的后续行暂存等待）
+    std::thread report_writer([&]() {
+        trace_thread_name("report-writer");
+        std::map<int, OcrResult> waiting;
+        auto write_result = [&](const OcrResult& res) {
+            if (with_report) {
+                TraceScope scope(TRACE_PDF_EMIT, res.lang_code);
+                writer.add_result(res);
+            }
+            if (config.on_result) config.on_result(res);
+            stats.results++;
+            if (track) {
+                std::string key = manifest_row_key(res);
+                ManifestEntry entry;
+                {
+                    std::lock_guard<std::mutex> lock(manifest_mutex);
+                    auto it = manifest.rows.find(key);
+                    if (it == manifest.rows.end()) return;
+                    it->second.result = res;
+                    it->second.result.report_image.reset();
+                    std::vector<OcrTextBox>().swap(it->second.result.text_boxes);
+                    if (config.journal) entry = it->second;
+                }
+                if (config.journal) config.journal->append(key, entry);
+            }
+        };
+        auto write_ready = [&]() {
+            while (true) {
+                int next_line;
+                {
+                    std::lock_guard<std::mutex> lock(order_mutex);
+                    if (result_order.empty()) return;
+                    next_line = result_order.front();
+                }
+                auto it = waiting.find(next_line);
+                if (it == waiting.end()) return;
+                write_result(it->second);
+                waiting.erase(it);
+                std::lock_guard<std::mutex> lock(order_mutex);
+                result_order.pop_front();
+            }
+        };
+
+        std::vector<OcrResult> results;
+        while (result_queue.pop(results)) {
+            for (auto& res : results) {
+                int line_num = res.line_num;
+                waiting.emplace(line_num, std::move(res));
+            }
+            write_ready();
+            if (trace_active()) trace_counter(TRACE_Q_REORDER, (int64_t)waiting.size());
+        }
+        write_ready();
+        for (const auto& item : waiting) write_result(item.second);
+    });
+
+    // 标注阶段：识别结果先由多个绘制线程并行生成标注图片（不占用识别线程），再交给写入阶段；
+    // 报告仍按原图嵌入，各行识别位置由写入器以矢量框叠加，报告大小只随不同图片数增长
+    bool thumb_mode = config.report_layout.image_mode == REPORT_IMAGE_THUMB;
+    int render_threads = annotate ? std::max(1, config.render_threads) : 0;
+    std::atomic<int> renderers_left(render_threads);
+    std::vector<std::thread> renderers;
+    for (int i = 0; i < render_threads; i++) {
+        renderers.emplace_back([&, i]() {
+            trace_thread_name("renderer-" + std::to_string(i));
+            std::vector<OcrResult> results;
+            while (render_queue.pop(results)) {
+                for (auto& res : results) {
+                    if (!res.report_image || res.report_image->source.empty()) continue;
+                    {
+                        TraceScope scope(TRACE_ANNOTATE, res.lang_code);
+                        render_annotated_image(res.report_image->source, res, config.annotate);
+                    }
+                    // 绘制完成后释放解码图像（缩略图模式下通过的记录只保留缩略图）
+                    if (report_images) {
+                        release_report_pixels(res, !(thumb_mode && res.is_ok));
+                    } else {
+                        res.report_image.reset();
+                    }
+                }
+                result_queue.push(std::move(results));
+            }
+            if (--renderers_left == 0) result_queue.close();
+        });
+    }
+
+    // 4. 分发阶段（当前线程）：按语种凑满小批后提交线程池识别，限制在途单元数形成背压
+    size_t max_inflight = config.max_inflight_units ? config.max_inflight_units : (size_t)pool.size() * 2;
+    std::vector<std::vector<OcrJob>> pending(lang_id_count());
+    std::deque<std::shared_future<void>> inflight;
+    OcrResultSink sink = [&result_queue, &render_queue, &text_counts, thumb_mode, annotate](std::vector<OcrResult>&& results) {
+        for (auto& res : results) {
+            text_counts.add(res.text);
+            // 缩略图模式下通过的记录只需缩略图，不再持有原图像素（标注时由绘制线程处理）
+            if (!annotate && thumb_mode && res.is_ok) release_report_pixels(res, false);
+        }
+        (annotate ? render_queue : result_queue).push(std::move(results));
+    };
+
+    auto flush = [&](LangId lang_id) {
+        std::vector<OcrJob>& jobs = pending[lang_id];
+        if (jobs.empty()) return;
+        std::vector<PoolTask> units;
+        units.push_back(make_ocr_unit(std::move(jobs), lang_code_of(lang_id), config.confidence, sink));
+        jobs.clear();
+        inflight.push_back(pool.submit(std::move(units)));
+
+        while (!inflight.empty() &&
+               inflight.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            inflight.pop_front();
+        }
+        size_t limit = config.inflight_share ? std::max<size_t>(1, config.inflight_share->load()) : max_inflight;
+        while (inflight.size() > limit) {
+            inflight.front().wait();
+            inflight.pop_front();
+        }
+    };
+
+    OcrJob job;
+    while (decoded_queue.pop(job)) {
+        // 每分发一张图片采样一次各队列深度
+        if (trace_active()) {
+            trace_counter(TRACE_Q_ROWS, (int64_t)row_queue.size());
+            trace_counter(TRACE_Q_RESOLVED, (int64_t)resolved_queue.size());
+            trace_counter(TRACE_Q_DECODED, (int64_t)decoded_queue.size());
+            trace_counter(TRACE_Q_RESULTS, (int64_t)result_queue.size());
+            trace_counter(TRACE_Q_INFLIGHT, (int64_t)inflight.size());
+        }
+        // 未知语种单独成批（没有模型编码，识别失败后按未通过记录报告，不改用英文模型）
+        LangId lang_id = job.meta.lang_id;
+        pending[lang_id].push_back(std::move(job));
+        if (pending[lang_id].size() >= OCR_UNIT_IMAGE_NUM) {
+            flush(lang_id);
+        }
+        // 上游暂时没有新图片时提交未满的小批，避免工作线程空等
+        if (decoded_queue.size() == 0) {
+            for (size_t i = 0; i < pending.size(); i++) flush((LangId)i);
+        }
+    }
+    for (size_t i = 0; i < pending.size(); i++) flush((LangId)i);
+    for (auto& future : inflight) future.wait();
+    if (annotate) {
+        render_queue.close();
+    } else {
+        result_queue.close();
+    }
+
+    reader.join();
+    resolver.join();
+    for (auto& decoder : decoders) decoder.join();
+    for (auto& renderer : renderers) renderer.join();
+    report_writer.join();
+
+    // 合并分片计数：报告中的出现次数为全部结果的最终值，与识别完成的先后无关
+    // （按作业各自保存，多个作业同时运行时互不影响）
+    std::map<std::string, int> final_counts = text_counts.snapshot();
+    bool ok = true;
+    if (with_report) {
+        TraceScope scope(TRACE_PDF_SAVE);
+        writer.set_text_counts(final_counts);
+        ok = writer.close();
+    }
+    if (config.manifest_out) {
+        // 只保留已得到识别结果的记录
+        config.manifest_out->rows.clear();
+        for (auto& item : manifest.rows) {
+            if (item.second.result.lang_code.empty()) continue;
+            item.second.result.count = final_counts[item.second.result.text];
+            config.manifest_out->rows.insert(std::move(item));
+        }
+    }
+    return ok && csv_ok;
+}
@@ -0,0 +1,84 @@
+#include "record_store.h"
+#include "data_struct.h"
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+// 字符串池分片：按文本哈希分散加锁，多个CSV解析线程同时驻留互不阻塞
+struct InternShard {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, const std::string*> index; // 键指向storage中的文本
+    std::deque<std::string> storage;                                // deque追加不移动已有元素
+};
+
+static const size_t INTERN_SHARD_NUM = 16;
+static InternShard g_intern_shards[INTERN_SHARD_NUM];
+static std::atomic<size_t> g_interned_count(0);
+static std::atomic<size_t> g_interned_bytes(0);
+
+const std::string* intern_string(std::string_view text) {
+    if (text.empty()) return &InternedString().str();
+    InternShard& shard = g_intern_shards[std::hash<std::string_view>()(text) % INTERN_SHARD_NUM];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(text);
+    if (it != shard.index.end()) return it->second;
+    shard.storage.emplace_back(text);
+    const std::string* stored = &shard.storage.back();
+    shard.index.emplace(std::string_view(*stored), stored);
+    g_interned_count++;
+    g_interned_bytes += stored->capacity() + sizeof(std::string);
+    return stored;
+}
+
+size_t interned_string_count() {
+    return g_interned_count;
+}
+
+size_t interned_string_bytes() {
+    return g_interned_bytes;
+}
+
+// 语种编号表：首次使用时由LANG_CODE_MAP生成（下标0为未知语种）
+struct LangTable {
+    std::vector<InternedString> names;
+    std::vector<InternedString> codes;
+};
+
+static const LangTable& lang_table() {
+    static const LangTable table = []() {
+        LangTable t;
+        t.names.push_back(InternedString());
+        t.codes.push_back(InternedString());
+        for (const auto& item : LANG_CODE_MAP) {
+            if (t.names.size() > UINT8_MAX) {
+                std::cerr << "语种数超出上限，忽略：" << item.first << std::endl;
+                continue;
+            }
+            t.names.push_back(item.first);
+            t.codes.push_back(item.second);
+        }
+        return t;
+    }();
+    return table;
+}
+
+LangId lang_id_of(const std::string& lang) {
+    const LangTable& table = lang_table();
+    for (size_t i = 1; i < table.names.size(); i++) {
+        if (table.names[i] == lang) return (LangId)i;
+    }
+    return LANG_UNKNOWN;
+}
+
+size_t lang_id_count() {
+    return lang_table().names.size();
+}
+
+const InternedString& lang_code_of(LangId id) {
+    const LangTable& table = lang_table();
+    return table.codes[id < table.codes.size() ? id : LANG_UNKNOWN];
+}
@@ -0,0 +1,93 @@
+#include "region_map.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <unistd.h>
+
+std::string region_key(const CsvMeta& meta) {
+    if (!meta.screen_id.empty() && !meta.part_id.empty()) return meta.screen_id.str() + "/" + meta.part_id.str();
+    if (!meta.part_id.empty()) return meta.part_id;
+    return meta.screen_id;
+}
+
+bool find_region(const RegionMap& regions, const CsvMeta& meta, RegionRect& rect) {
+    if (regions.empty()) return false;
+
+    const std::string keys[3] = {
+        (!meta.screen_id.empty() && !meta.part_id.empty()) ? meta.screen_id.str() + "/" + meta.part_id.str() : "",
+        meta.part_id,
+        meta.screen_id
+    };
+    for (const auto& key : keys) {
+        if (key.empty()) continue;
+        auto it = regions.find(key);
+        if (it != regions.end() && it->second.w > 0 && it->second.h > 0) {
+            rect = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool load_region_map(const std::string& path, RegionMap& regions) {
+    std::ifstream in(path, std::ios::in);
+    if (!in) {
+        std::cerr << "无法打开区域表：" << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_num = 0;
+    while (std::getline(in, line)) {
+        line_num++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        // 键中可能含逗号，从行尾取4个数值
+        size_t pos = line.size();
+        int values[4];
+        bool ok = true;
+        for (int i = 3; i >= 0; i--) {
+            size_t comma = (pos == 0) ? std::string::npos : line.rfind(',', pos - 1);
+            if (comma == std::string::npos) {
+                ok = false;
+                break;
+            }
+            values[i] = atoi(line.substr(comma + 1, pos - comma - 1).c_str());
+            pos = comma;
+        }
+        if (!ok || pos == 0) {
+            std::cerr << "区域表第" << line_num << "行格式错误，跳过！" << std::endl;
+            continue;
+        }
+
+        RegionRect rect;
+        rect.x = values[0];
+        rect.y = values[1];
+        rect.w = values[2];
+        rect.h = values[3];
+        regions[line.substr(0, pos)] = rect;
+    }
+    return true;
+}
+
+bool save_region_map(const std::string& path, const RegionMap& regions) {
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::out | std::ios::trunc);
+    if (!out) {
+        std::cerr << "无法写入区域表：" << path << std::endl;
+        return false;
+    }
+    out << "# 键(ScreenID/PartID、PartID或ScreenID),x,y,w,h\n";
+    for (const auto& item : regions) {
+        const RegionRect& rect = item.second;
+        out << item.first << "," << rect.x << "," << rect.y << "," << rect.w << "," << rect.h << "\n";
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "区域表保存失败：" << path << std::endl;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
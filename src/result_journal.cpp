@@ -0,0 +1,146 @@
+#include "result_journal.h"
+#include "hash_utils.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 日志格式（文本，只追加）：
+//   RJRNL1
+//   <校验和16位十六进制>\t<清单记录>
+// 校验和为清单记录的哈希；读取时遇到校验失败或缺少换行的记录即视为崩溃时写了一半，其后内容丢弃
+static const char JOURNAL_HEADER[] = "RJRNL1\n";
+
+// 读取日志中的有效记录，返回有效内容的长度（0表示文件不是日志）
+static size_t load_journal(const std::string& path, RunManifest& recovered) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) return 0;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t header_len = sizeof(JOURNAL_HEADER) - 1;
+    if (data.compare(0, header_len, JOURNAL_HEADER) != 0) return 0;
+
+    size_t pos = header_len;
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        if (end == std::string::npos || end - pos < 18 || data[pos + 16] != '\t') break;
+        std::string record = data.substr(pos + 17, end - pos - 17);
+        uint64_t checksum = strtoull(data.substr(pos, 16).c_str(), nullptr, 16);
+        if (hash_string(record) != checksum) break;
+
+        std::string key;
+        ManifestEntry entry;
+        if (!read_manifest_entry(record, key, entry)) break;
+        recovered.rows[key] = entry;     // 同一记录多次写入时以最后一次为准
+        pos = end + 1;
+    }
+    if (pos < data.size()) {
+        std::cerr << "结果日志末尾有" << data.size() - pos << "字节不完整，已丢弃：" << path << std::endl;
+    }
+    return pos;
+}
+
+ResultJournal::ResultJournal()
+    : m_fd(-1), m_good_size(0), m_pending_num(0), m_sync_every(64), m_sync_interval(1000), m_appended(0), m_failed(false) {}
+
+ResultJournal::~ResultJournal() {
+    if (m_fd >= 0) close(false);
+}
+
+bool ResultJournal::open(const std::string& path, bool resume, size_t sync_every, int sync_interval_ms) {
+    m_path = path;
+    m_sync_every = std::max<size_t>(1, sync_every);
+    m_sync_interval = std::chrono::milliseconds(sync_interval_ms);
+    m_recovered = RunManifest();
+    m_failed = false;
+
+    size_t valid_size = resume ? load_journal(path, m_recovered) : 0;
+    if (valid_size > 0) {
+        // 截掉不完整的尾部后继续追加
+        m_fd = ::open(path.c_str(), O_WRONLY);
+        if (m_fd >= 0 && (ftruncate(m_fd, valid_size) != 0 || lseek(m_fd, 0, SEEK_END) < 0)) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    } else {
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd >= 0 && write(m_fd, JOURNAL_HEADER, sizeof(JOURNAL_HEADER) - 1) != (ssize_t)(sizeof(JOURNAL_HEADER) - 1)) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+    if (m_fd < 0) {
+        std::cerr << "无法打开结果日志：" << path << std::endl;
+        return false;
+    }
+    m_good_size = valid_size > 0 ? (off_t)valid_size : (off_t)(sizeof(JOURNAL_HEADER) - 1);
+    m_last_sync = std::chrono::steady_clock::now();
+    return true;
+}
+
+void ResultJournal::append(const std::string& key, const ManifestEntry& entry) {
+    // 恢复后原样复用的记录已在日志中
+    auto it = m_recovered.rows.find(key);
+    if (it != m_recovered.rows.end() && manifest_entry_unchanged(it->second, entry)) return;
+
+    std::ostringstream record;
+    write_manifest_entry(record, key, entry);
+    std::string line = hash_to_hex(hash_string(record.str())) + "\t" + record.str() + "\n";
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0 || m_failed) return;
+    m_pending += line;
+    m_pending_num++;
+    m_appended++;
+    // 攒够一批或距上次同步超过间隔时写出并fsync
+    if (m_pending_num >= m_sync_every || std::chrono::steady_clock::now() - m_last_sync >= m_sync_interval) {
+        flush_locked();
+    }
+}
+
+bool ResultJournal::flush_locked() {
+    if (m_failed) {
+        m_pending.clear();
+        m_pending_num = 0;
+        return false;
+    }
+    size_t written = 0;
+    while (written < m_pending.size()) {
+        ssize_t n = write(m_fd, m_pending.data() + written, m_pending.size() - written);
+        if (n <= 0) break;
+        written += n;
+    }
+    bool ok = (written == m_pending.size()) && fdatasync(m_fd) == 0;
+    if (ok) {
+        m_good_size += written;
+    } else {
+        // 截掉写了一半的记录并停止追加，否则其后的记录在恢复时会随不完整记录一起被丢弃
+        if (ftruncate(m_fd, m_good_size) != 0 || lseek(m_fd, m_good_size, SEEK_SET) < 0) {
+            std::cerr << "结果日志截断失败：" << m_path << std::endl;
+        }
+        std::cerr << "结果日志写入失败，停止记录：" << m_path << std::endl;
+        m_failed = true;
+    }
+    m_pending.clear();
+    m_pending_num = 0;
+    m_last_sync = std::chrono::steady_clock::now();
+    return ok;
+}
+
+bool ResultJournal::sync() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return false;
+    return flush_locked();
+}
+
+bool ResultJournal::close(bool remove) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return false;
+    bool ok = flush_locked();
+    ::close(m_fd);
+    m_fd = -1;
+    if (remove) unlink(m_path.c_str());
+    return ok && !m_failed;
+}
@@ -0,0 +1,220 @@
+#include "run_manifest.h"
+#include "hash_utils.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 清单中的字段以制表符分隔，字段内的反斜杠、制表符与换行转义
+static void write_field(std::ostream& out, const std::string& value) {
+    out << '\t';
+    for (char c : value) {
+        switch (c) {
+            case '\\': out << "\\\\"; break;
+            case '\t': out << "\\t"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            default: out << c;
+        }
+    }
+}
+
+static std::string unescape_field(const std::string& line, size_t begin, size_t end) {
+    std::string value;
+    value.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        char c = line[i];
+        if (c == '\\' && i + 1 < end) {
+            char n = line[++i];
+            value += (n == 't') ? '\t' : (n == 'n') ? '\n' : (n == 'r') ? '\r' : n;
+        } else {
+            value += c;
+        }
+    }
+    return value;
+}
+
+// 从pos处（指向制表符）开始拆分剩余字段
+static std::vector<std::string> split_fields(const std::string& line, size_t pos) {
+    std::vector<std::string> fields;
+    while (pos < line.size() && line[pos] == '\t') {
+        size_t next = line.find('\t', pos + 1);
+        if (next == std::string::npos) next = line.size();
+        fields.push_back(unescape_field(line, pos + 1, next));
+        pos = next;
+    }
+    return fields;
+}
+
+std::string manifest_row_key(const CsvMeta& meta) {
+    return meta.seq_id + "/" + meta.string_id + "/" + meta.lang.str();
+}
+
+std::string manifest_row_key(const OcrResult& res) {
+    return res.seq_id + "/" + res.string_id + "/" + res.lang.str();
+}
+
+uint64_t manifest_row_hash(const CsvMeta& meta, const std::string& settings, double confidence) {
+    std::ostringstream out;
+    out << meta.module << '\x1f' << meta.desc << '\x1f' << meta.lang_text << '\x1f'
+        << meta.screen_id << '\x1f' << meta.part_id << '\x1f' << settings << '\x1f' << confidence;
+    return hash_string(out.str(), hash_string(manifest_row_key(meta)));
+}
+
+bool stat_image_file(const std::string& img_path, ManifestEntry& entry) {
+    struct stat st;
+    if (stat(img_path.c_str(), &st) != 0) return false;
+    entry.img_path = img_path;
+    entry.img_mtime_sec = st.st_mtim.tv_sec;
+    entry.img_mtime_nsec = st.st_mtim.tv_nsec;
+    entry.img_size = st.st_size;
+    return true;
+}
+
+bool manifest_entry_unchanged(const ManifestEntry& prev, const ManifestEntry& cur) {
+    return prev.row_hash == cur.row_hash && prev.img_path == cur.img_path &&
+           prev.img_mtime_sec == cur.img_mtime_sec && prev.img_mtime_nsec == cur.img_mtime_nsec &&
+           prev.img_size == cur.img_size && prev.img_hash != 0;
+}
+
+void write_result_fields(std::ostream& out, const OcrResult& res) {
+    char number[64];
+    write_field(out, res.lang);
+    write_field(out, res.lang_code);
+    write_field(out, res.img_id);
+    write_field(out, res.text);
+    write_field(out, res.is_ok ? "1" : "0");
+    snprintf(number, sizeof(number), "%.6f", res.confidence);
+    write_field(out, number);
+    snprintf(number, sizeof(number), "%.6f", res.match_score);
+    write_field(out, number);
+    write_field(out, std::to_string(res.count));
+    write_field(out, res.annotated_img);
+    std::string box;
+    for (size_t i = 0; i < res.box.size(); i++) {
+        if (i) box += ",";
+        box += std::to_string(res.box[i]);
+    }
+    write_field(out, box);
+    write_field(out, res.seq_id);
+    write_field(out, res.string_id);
+    write_field(out, res.screen_id);
+    write_field(out, res.part_id);
+    write_field(out, res.doc_position);
+    write_field(out, std::to_string(res.tier));
+    write_field(out, res.img_path);
+}
+
+bool read_result_fields(const std::string& line, size_t pos, OcrResult& res) {
+    std::vector<std::string> f = split_fields(line, pos);
+    if (f.size() < 15) return false;
+
+    res.lang = f[0];
+    res.lang_code = f[1];
+    res.img_id = f[2];
+    res.text = f[3];
+    res.is_ok = (f[4] == "1");
+    res.confidence = atof(f[5].c_str());
+    res.match_score = atof(f[6].c_str());
+    res.count = atoi(f[7].c_str());
+    res.annotated_img = f[8];
+    res.box.clear();
+    std::istringstream box(f[9]);
+    std::string value;
+    while (std::getline(box, value, ',')) res.box.push_back(atoi(value.c_str()));
+    res.seq_id = f[10];
+    res.string_id = f[11];
+    res.screen_id = f[12];
+    res.part_id = f[13];
+    res.doc_position = f[14];
+    res.tier = (f.size() > 15) ? atoi(f[15].c_str()) : OCR_TIER_NONE;
+    // 旧格式无原图路径字段，当时的标注图片路径即原图路径
+    res.img_path = (f.size() > 16) ? f[16] : res.annotated_img;
+    return true;
+}
+
+// 清单记录（一行）：
+//   R\t<记录键>\t<记录哈希>\t<图片路径>\t<mtime秒>\t<mtime纳秒>\t<大小>\t<图片哈希>\t<识别结果字段...>
+void write_manifest_entry(std::ostream& out, const std::string& key, const ManifestEntry& entry) {
+    out << "R";
+    write_field(out, key);
+    write_field(out, hash_to_hex(entry.row_hash));
+    write_field(out, entry.img_path);
+    write_field(out, std::to_string(entry.img_mtime_sec));
+    write_field(out, std::to_string(entry.img_mtime_nsec));
+    write_field(out, std::to_string(entry.img_size));
+    write_field(out, hash_to_hex(entry.img_hash));
+    write_result_fields(out, entry.result);
+}
+
+bool read_manifest_entry(const std::string& line, std::string& key, ManifestEntry& entry) {
+    if (line.empty() || line[0] != 'R') return false;
+    // 前7个字段为清单信息，其后为识别结果
+    size_t pos = 1;
+    std::vector<std::string> head;
+    for (int i = 0; i < 7 && pos < line.size(); i++) {
+        size_t next = line.find('\t', pos + 1);
+        if (next == std::string::npos) next = line.size();
+        head.push_back(unescape_field(line, pos + 1, next));
+        pos = next;
+    }
+    entry = ManifestEntry();
+    if (head.size() < 7 || !read_result_fields(line, pos, entry.result)) return false;
+    key = head[0];
+    entry.row_hash = strtoull(head[1].c_str(), nullptr, 16);
+    entry.img_path = head[2];
+    entry.img_mtime_sec = atol(head[3].c_str());
+    entry.img_mtime_nsec = atol(head[4].c_str());
+    entry.img_size = atoll(head[5].c_str());
+    entry.img_hash = strtoull(head[6].c_str(), nullptr, 16);
+    return true;
+}
+
+// 清单格式（文本）：
+//   RUNMF1
+//   <清单记录...>
+bool save_run_manifest(const std::string& path, const RunManifest& manifest) {
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out) {
+        std::cerr << "无法写入运行清单：" << path << std::endl;
+        return false;
+    }
+    out << "RUNMF1\n";
+    for (const auto& item : manifest.rows) {
+        write_manifest_entry(out, item.first, item.second);
+        out << "\n";
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "运行清单保存失败：" << path << std::endl;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool load_run_manifest(const std::string& path, RunManifest& manifest) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) return false;
+
+    manifest = RunManifest();
+    std::string line;
+    if (!std::getline(in, line) || line != "RUNMF1") return false;
+
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] != 'R') continue;
+        std::string key;
+        ManifestEntry entry;
+        if (!read_manifest_entry(line, key, entry)) {
+            std::cerr << "运行清单记录格式错误，已忽略：" << path << std::endl;
+            continue;
+        }
+        manifest.rows[key] = entry;
+    }
+    return true;
+}
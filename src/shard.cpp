@@ -0,0 +1,144 @@
+#include "shard.h"
+#include "run_manifest.h"
+#include "hash_utils.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+bool parse_shard_spec(const std::string& text, ShardSpec& spec) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 >= text.size()) return false;
+    char* end = nullptr;
+    long index = strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() + slash) return false;
+    long count = strtol(text.c_str() + slash + 1, &end, 10);
+    if (*end != '\0' || count < 1 || index < 0 || index >= count) return false;
+    spec.index = (int)index;
+    spec.count = (int)count;
+    return true;
+}
+
+int shard_of(const CsvMeta& meta, int shard_count) {
+    if (shard_count <= 1) return 0;
+    return (int)(hash_string(meta.string_id + '\x1f' + meta.lang.str()) % (uint64_t)shard_count);
+}
+
+// 结果文件格式（文本）：
+//   SHARD1\t<分片号>\t<分片数>
+//   R\t<CSV行号>\t<识别结果字段...>
+//   END\t<结果数>            （完整写出的标记，缺少时视为该分片未完成）
+bool ShardResultWriter::open(const std::string& path, const ShardSpec& spec) {
+    m_path = path;
+    m_tmp_path = path + ".tmp";
+    m_out.open(m_tmp_path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!m_out) {
+        std::cerr << "无法写入分片结果：" << path << std::endl;
+        return false;
+    }
+    m_out << "SHARD1\t" << spec.index << "\t" << spec.count << "\n";
+    m_count = 0;
+    return true;
+}
+
+void ShardResultWriter::add(const OcrResult& res) {
+    m_out << "R\t" << res.line_num;
+    write_result_fields(m_out, res);
+    m_out << "\n";
+    m_count++;
+}
+
+bool ShardResultWriter::close() {
+    m_out << "END\t" << m_count << "\n";
+    m_out.close();
+    if (!m_out || rename(m_tmp_path.c_str(), m_path.c_str()) != 0) {
+        std::cerr << "分片结果保存失败：" << m_path << std::endl;
+        unlink(m_tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool load_shard_results(const std::string& path, ShardSpec& spec, std::vector<OcrResult>& results) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) {
+        std::cerr << "无法读取分片结果：" << path << std::endl;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, 7, "SHARD1\t") != 0 ||
+        sscanf(line.c_str() + 7, "%d\t%d", &spec.index, &spec.count) != 2) {
+        std::cerr << "分片结果格式错误：" << path << std::endl;
+        return false;
+    }
+
+    size_t expected = 0;
+    bool complete = false;
+    std::vector<OcrResult> loaded;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 2, "R\t") == 0) {
+            size_t pos = line.find('\t', 2);
+            OcrResult res;
+            if (pos == std::string::npos || !read_result_fields(line, pos, res)) {
+                std::cerr << "分片结果记录格式错误，已忽略：" << path << std::endl;
+                continue;
+            }
+            res.line_num = atoi(line.c_str() + 2);
+            loaded.push_back(std::move(res));
+        } else if (line.compare(0, 4, "END\t") == 0) {
+            expected = (size_t)atol(line.c_str() + 4);
+            complete = true;
+        }
+    }
+    if (!complete || expected != loaded.size()) {
+        std::cerr << "分片结果不完整：" << path << std::endl;
+        return false;
+    }
+    for (auto& res : loaded) results.push_back(std::move(res));
+    return true;
+}
+
+bool merge_shard_results(const std::vector<std::string>& paths, const std::string& pdf_output,
+                         const ReportLayout& layout, size_t& result_num) {
+    std::vector<OcrResult> results;
+    std::set<int> seen;
+    int shard_count = 0;
+    for (const auto& path : paths) {
+        ShardSpec spec;
+        if (!load_shard_results(path, spec, results)) return false;
+        if (shard_count == 0) shard_count = spec.count;
+        if (spec.count != shard_count) {
+            std::cerr << "分片数不一致：" << path << "（" << spec.count << "，其他分片为" << shard_count << "）" << std::endl;
+            return false;
+        }
+        if (!seen.insert(spec.index).second) {
+            std::cerr << "重复的分片：" << spec.index << "/" << spec.count << "（" << path << "）" << std::endl;
+            return false;
+        }
+    }
+    if ((int)seen.size() != shard_count) {
+        std::cerr << "缺少分片：共" << shard_count << "片，只提供了" << seen.size() << "片" << std::endl;
+        return false;
+    }
+
+    // 各分片的记录互不重叠，按CSV行号排序即得到与单机运行相同的报告顺序
+    std::stable_sort(results.begin(), results.end(), [](const OcrResult& a, const OcrResult& b) {
+        return a.line_num < b.line_num;
+    });
+
+    // 出现次数为全部分片合计的全局值
+    std::map<std::string, int> counts;
+    for (const auto& res : results) counts[res.text]++;
+    for (auto& res : results) res.count = counts[res.text];
+
+    PdfReportWriter writer;
+    if (!writer.open(pdf_output, layout)) return false;
+    for (const auto& res : results) writer.add_result(res);
+    writer.set_text_counts(counts);
+    result_num = results.size();
+    return writer.close();
+}
@@ -0,0 +1,35 @@
+#include "text_counter.h"
+#include "hash_utils.h"
+
+TextCounter::TextCounter(size_t shard_num) {
+    if (shard_num == 0) shard_num = 1;
+    for (size_t i = 0; i < shard_num; i++) {
+        m_shards.emplace_back(new Shard());
+    }
+}
+
+TextCounter::Shard& TextCounter::shard_of(const std::string& text) const {
+    return *m_shards[hash_string(text) % m_shards.size()];
+}
+
+void TextCounter::add(const std::string& text, int n) {
+    Shard& shard = shard_of(text);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.counts[text] += n;
+}
+
+int TextCounter::get(const std::string& text) const {
+    Shard& shard = shard_of(text);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.counts.find(text);
+    return (it != shard.counts.end()) ? it->second : 0;
+}
+
+std::map<std::string, int> TextCounter::snapshot() const {
+    std::map<std::string, int> merged;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& item : shard->counts) merged[item.first] += item.second;
+    }
+    return merged;
+}
@@ -0,0 +1,194 @@
+#include "text_matcher.h"
+#include "utf8_utils.h"
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
+
+std::u32string normalize_for_match(const std::string& text, const std::string& lang_code) {
+    bool turkish = (lang_code == "tur");
+    bool arabic = (lang_code == "ara");
+    bool thai = (lang_code == "tha");
+
+    std::u32string composed = compose_nfc(utf8_decode(text));
+    std::u32string out;
+    out.reserve(composed.size());
+    bool pending_space = false;
+    for (char32_t cp : composed) {
+        if (is_format_cp(cp)) continue;
+        if (is_space_cp(cp)) {
+            pending_space = !out.empty();
+            continue;
+        }
+        if (arabic) {
+            // 去除Tatweel与短元音/Shadda等符号，统一Alef与Ya的写法
+            if (cp == 0x0640 || (cp >= 0x064B && cp <= 0x0652) || cp == 0x0670) continue;
+            if (cp == 0x0622 || cp == 0x0623 || cp == 0x0625) cp = 0x0627;
+            if (cp == 0x0649) cp = 0x064A;
+        }
+        // 泰语不以空格分词，识别结果中的字间空白全部忽略
+        if (pending_space && !thai) out.push_back(' ');
+        pending_space = false;
+
+        if (cp == 0x00DF) {
+            // ß 全折叠为 ss
+            out.push_back('s');
+            out.push_back('s');
+            continue;
+        }
+        out.push_back(fold_case(cp, turkish));
+    }
+    return out;
+}
+
+// 模式串的位掩码表：每个码点在模式各位置出现的位向量（按64位分块）
+struct PatternMasks {
+    int blocks;
+    std::unordered_map<char32_t, std::vector<uint64_t>> peq;
+    std::vector<uint64_t> empty;
+
+    explicit PatternMasks(const std::u32string& pattern) {
+        blocks = (int)((pattern.size() + 63) / 64);
+        empty.assign(blocks, 0);
+        peq.reserve(pattern.size() * 2);
+        for (size_t i = 0; i < pattern.size(); i++) {
+            auto it = peq.find(pattern[i]);
+            if (it == peq.end()) it = peq.insert(std::make_pair(pattern[i], empty)).first;
+            it->second[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    const uint64_t* get(char32_t cp) const {
+        auto it = peq.find(cp);
+        return it == peq.end() ? empty.data() : it->second.data();
+    }
+};
+
+// 单个64行分块推进一列（Myers 1999分块算法），hin/返回值为块上/下边界的水平增量（-1/0/+1）
+static inline int advance_block(uint64_t& Pv, uint64_t& Mv, uint64_t Eq, int hin) {
+    uint64_t Xv = Eq | Mv;
+    if (hin < 0) Eq |= 1;
+    uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    uint64_t Ph = Mv | ~(Xh | Pv);
+    uint64_t Mh = Pv & Xh;
+
+    int hout = 0;
+    if (Ph & ((uint64_t)1 << 63)) hout = 1;
+    else if (Mh & ((uint64_t)1 << 63)) hout = -1;
+
+    Ph <<= 1;
+    Mh <<= 1;
+    if (hin < 0) Mh |= 1;
+    else if (hin > 0) Ph |= 1;
+
+    Pv = Mh | ~(Xv | Ph);
+    Mv = Ph & Xv;
+    return hout;
+}
+
+static inline int popcount64(uint64_t x) {
+    return __builtin_popcountll(x);
+}
+
+// 位并行DP：global为true时计算全局编辑距离，否则为半全局（模式可从文本任意位置开始），
+// 返回最后一行的最小值及其列位置（end为匹配结束位置，开区间）
+static int bit_parallel_dp(const std::u32string& pattern, const std::u32string& text, bool global, int* best_end) {
+    int m = (int)pattern.size();
+    if (m == 0) {
+        if (best_end) *best_end = 0;
+        return global ? (int)text.size() : 0;
+    }
+
+    PatternMasks masks(pattern);
+    int blocks = masks.blocks;
+    std::vector<uint64_t> P(blocks, ~(uint64_t)0), M(blocks, 0);
+    // 各块最后一行在当前列的取值（第0列为行号）
+    std::vector<int> bottom(blocks);
+    for (int b = 0; b < blocks; b++) bottom[b] = (b + 1) * 64;
+
+    // 最后一块中真实模式末行的位置掩码（末行之后的填充行不影响其上方的取值）
+    int last_row = (m - 1) % 64;
+    uint64_t last_mask = (last_row == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (last_row + 1)) - 1);
+
+    int best = m;
+    int best_pos = 0;
+    int n = (int)text.size();
+    for (int j = 0; j < n; j++) {
+        const uint64_t* eq = masks.get(text[j]);
+        int hin = global ? 1 : 0;
+        for (int b = 0; b < blocks; b++) {
+            hin = advance_block(P[b], M[b], eq[b], hin);
+            bottom[b] += hin;
+        }
+
+        int top = (blocks > 1) ? bottom[blocks - 2] : (global ? j + 1 : 0);
+        int score = top + popcount64(P[blocks - 1] & last_mask) - popcount64(M[blocks - 1] & last_mask);
+        if (global) {
+            best = score;
+            best_pos = j + 1;
+        } else if (score < best) {
+            best = score;
+            best_pos = j + 1;
+        }
+    }
+    if (best_end) *best_end = best_pos;
+    return best;
+}
+
+int edit_distance(const std::u32string& a, const std::u32string& b) {
+    // 较短的串作模式，减少分块数
+    const std::u32string& pattern = (a.size() <= b.size()) ? a : b;
+    const std::u32string& text = (a.size() <= b.size()) ? b : a;
+    return bit_parallel_dp(pattern, text, true, nullptr);
+}
+
+// 编辑距离下界：模式中在文本里找不到对应字符的个数（多重集合差）
+static int char_count_lower_bound(const std::u32string& pattern, const std::u32string& text) {
+    std::unordered_map<char32_t, int> counts;
+    counts.reserve(pattern.size() * 2);
+    for (char32_t cp : pattern) counts[cp]++;
+    int matched = 0;
+    for (char32_t cp : text) {
+        auto it = counts.find(cp);
+        if (it != counts.end() && it->second > 0) {
+            it->second--;
+            matched++;
+        }
+    }
+    return (int)pattern.size() - matched;
+}
+
+TextMatch find_best_match(const std::u32string& pattern, const std::u32string& text, int max_distance) {
+    TextMatch match;
+    int m = (int)pattern.size();
+    if (m == 0) {
+        match.score = 1;
+        match.distance = 0;
+        return match;
+    }
+    if (max_distance >= 0 && char_count_lower_bound(pattern, text) > max_distance) {
+        return match;
+    }
+
+    int end = 0;
+    int distance = bit_parallel_dp(pattern, text, false, &end);
+
+    // 反向比对确定起点：反转的模式在反转的文本前缀上做半全局比对
+    std::u32string rev_pattern(pattern.rbegin(), pattern.rend());
+    std::u32string rev_text(text.begin(), text.begin() + end);
+    std::reverse(rev_text.begin(), rev_text.end());
+    int rev_end = 0;
+    bit_parallel_dp(rev_pattern, rev_text, false, &rev_end);
+
+    match.distance = distance;
+    match.end = end;
+    match.begin = end - rev_end;
+    match.score = std::max(0.0, 1.0 - (double)distance / m);
+    return match;
+}
+
+TextMatch match_expected_text(const std::string& expected, const std::string& recognized, const std::string& lang_code) {
+    std::u32string pattern = normalize_for_match(expected, lang_code);
+    std::u32string text = normalize_for_match(recognized, lang_code);
+    return find_best_match(pattern, text);
+}
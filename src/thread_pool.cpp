@@ -1,110 +1,218 @@
 #include "thread_pool.h"
+#include "trace.h"
 #include <iostream>
-#include <cstring>
 #include <algorithm>
-#include <thread>
-#include <mutex>
-#include <unistd.h>
-#include "ocr_processor.h"
-#include "data_struct.h"
-
-// 线程池全局变量
-static pthread_t* g_threads = nullptr;
-static int g_thread_num = 0;
-static std::vector<LangTask> g_tasks;
-static std::vector<OcrResult> g_all_results;
-static std::mutex g_task_mutex;
-static std::mutex g_result_mutex;
-static bool g_stop = false;
-
-// 线程工作函数
-void* worker_thread(void* arg) {
-    int thread_id = *(int*)arg;
-    delete (int*)arg;
-
-    while (!g_stop) {
-        LangTask task;
-        bool has_task = false;
-
-        {
-            std::lock_guard<std::mutex> lock(g_task_mutex);
-            if (!g_tasks.empty()) {
-                task = g_tasks.back();
-                g_tasks.pop_back();
-                has_task = true;
-            }
-        }
+#include <map>
+#include <stdexcept>
+#include <exception>
 
-        if (!has_task) {
-            usleep(10000);
-            continue;
+ThreadPool::ThreadPool(int thread_num, ThreadHook on_start, ThreadHook on_exit)
+    : m_on_start(on_start), m_on_exit(on_exit), m_queued(0), m_stop(false) {
+    if (thread_num <= 0) thread_num = std::max(1, (int)std::thread::hardware_concurrency());
+
+    for (int i = 0; i < thread_num; i++) {
+        m_workers.emplace_back(new Worker());
+    }
+    for (int i = 0; i < thread_num; i++) {
+        m_threads.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+// 提交任务：同亲和键的任务连续分配，每组从当前负载最小的线程开始，
+// 填满平均负载后换下一个线程，使每个线程尽量只处理少数亲和键；剩余不均由窃取消除
+std::shared_future<void> ThreadPool::submit(std::vector<PoolTask> tasks) {
+    std::shared_ptr<Batch> batch(new Batch());
+    batch->remaining = tasks.size();
+    std::shared_future<void> future = batch->done.get_future().share();
+    if (tasks.empty()) {
+        batch->done.set_value();
+        return future;
+    }
+
+    // 按亲和键分组（保持提交顺序），大组优先分配
+    std::map<std::string, size_t> group_idx;
+    std::vector<std::vector<PoolTask*>> groups;
+    std::vector<size_t> group_weight;
+    size_t total = 0;
+    for (auto& task : tasks) {
+        auto it = group_idx.find(task.affinity);
+        if (it == group_idx.end()) {
+            it = group_idx.insert(std::make_pair(task.affinity, groups.size())).first;
+            groups.emplace_back();
+            group_weight.push_back(0);
         }
+        groups[it->second].push_back(&task);
+        group_weight[it->second] += task.weight;
+        total += task.weight;
+    }
+    std::vector<size_t> order(groups.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&group_weight](size_t a, size_t b) {
+        return group_weight[a] > group_weight[b];
+    });
+
+    int worker_num = (int)m_workers.size();
+    std::vector<size_t> load(worker_num);
+    for (int i = 0; i < worker_num; i++) {
+        std::lock_guard<std::mutex> lock(m_workers[i]->mutex);
+        load[i] = m_workers[i]->load;
+        total += load[i];
+    }
+    size_t target = (total + worker_num - 1) / worker_num;
 
-        std::cout << "线程" << thread_id << "开始处理语种：" << task.lang << "（编码：" << task.lang_code << "）" << std::endl;
-        for (const auto& [img_path, csv_meta] : task.img_meta_list) {
-            OcrResult res = process_image(
-                img_path, 
-                csv_meta, 
-                task.confidence_threshold
-            );
-            
-            {
-                std::lock_guard<std::mutex> lock(g_result_mutex);
-                g_all_results.push_back(res);
+    std::vector<std::vector<Item>> assigned(worker_num);
+    for (size_t g : order) {
+        int worker = std::min_element(load.begin(), load.end()) - load.begin();
+        for (PoolTask* task : groups[g]) {
+            if (load[worker] >= target) {
+                worker = std::min_element(load.begin(), load.end()) - load.begin();
             }
+            load[worker] += task->weight;
+            Item item;
+            item.task = std::move(*task);
+            item.batch = batch;
+            assigned[worker].push_back(std::move(item));
+        }
+    }
+
+    // 先计数再入队，避免线程取到任务时计数尚未增加；与停止标志在同一把锁下检查，
+    // 已停止的线程池不再接收任务（不会有线程执行），返回的future直接带异常
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        if (m_stop) {
+            batch->done.set_exception(std::make_exception_ptr(std::runtime_error("线程池已停止，任务未执行")));
+            return future;
+        }
+        m_queued += (long)tasks.size();
+    }
+    for (int i = 0; i < worker_num; i++) {
+        if (assigned[i].empty()) continue;
+        std::lock_guard<std::mutex> lock(m_workers[i]->mutex);
+        for (auto& item : assigned[i]) {
+            m_workers[i]->load += item.task.weight;
+            m_workers[i]->items.push_back(std::move(item));
         }
-        std::cout << "线程" << thread_id << "完成语种：" << task.lang << "的处理！共处理" << task.img_meta_list.size() << "张图片" << std::endl;
     }
+    // 与等待线程的谓词检查同步一次，避免丢失唤醒
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+    }
+    m_wake.notify_all();
+    return future;
+}
 
-    pthread_exit(nullptr);
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
 }
 
-// 初始化线程池
-bool init_thread_pool(int thread_num) {
-    if (thread_num <= 0) thread_num = std::min(10, (int)std::thread::hardware_concurrency());
-    g_thread_num = thread_num;
-    g_threads = new pthread_t[thread_num];
+// 从本地队列头部取一个任务
+bool ThreadPool::pop_local(int worker_id, Item& item) {
+    Worker& worker = *m_workers[worker_id];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.items.empty()) return false;
+    item = std::move(worker.items.front());
+    worker.items.pop_front();
+    worker.load -= item.task.weight;
+    m_queued--;
+    return true;
+}
 
-    for (int i = 0; i < thread_num; i++) {
-        int* id = new int(i);
-        if (pthread_create(&g_threads[i], nullptr, worker_thread, id) != 0) {
-            std::cerr << "线程" << i << "创建失败！" << std::endl;
-            return false;
+// 从其他线程尾部窃取：优先窃取与当前亲和键相同的任务（如复用已加载的引擎），
+// 否则从剩余最多的队列窃取；一次窃取对方尾部同亲和键连续任务的一半
+bool ThreadPool::steal(int worker_id, const std::string& cur_affinity, Item& item) {
+    int worker_num = (int)m_workers.size();
+    int victim = -1;
+    size_t victim_load = 0;
+    bool victim_same = false;
+    for (int i = 0; i < worker_num; i++) {
+        if (i == worker_id) continue;
+        std::lock_guard<std::mutex> lock(m_workers[i]->mutex);
+        const auto& items = m_workers[i]->items;
+        if (items.empty()) continue;
+        bool same = (items.back().task.affinity == cur_affinity);
+        if ((same && !victim_same) || (same == victim_same && m_workers[i]->load > victim_load)) {
+            victim = i;
+            victim_load = m_workers[i]->load;
+            victim_same = same;
+        }
+    }
+    if (victim < 0) return false;
+
+    std::vector<Item> stolen;
+    size_t stolen_load = 0;
+    {
+        Worker& from = *m_workers[victim];
+        std::lock_guard<std::mutex> lock(from.mutex);
+        if (from.items.empty()) return false;
+        std::string affinity = from.items.back().task.affinity;
+        size_t max_steal = std::max<size_t>(1, from.items.size() / 2);
+        while (!from.items.empty() && stolen.size() < max_steal && from.items.back().task.affinity == affinity) {
+            stolen_load += from.items.back().task.weight;
+            stolen.push_back(std::move(from.items.back()));
+            from.items.pop_back();
         }
+        from.load -= stolen_load;
     }
 
-    g_stop = false;
+    item = std::move(stolen.back());
+    stolen.pop_back();
+    m_queued--;
+    if (!stolen.empty()) {
+        Worker& self = *m_workers[worker_id];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        for (auto it = stolen.rbegin(); it != stolen.rend(); ++it) {
+            self.load += it->task.weight;
+            self.items.push_back(std::move(*it));
+        }
+    }
     return true;
 }
 
-// 提交任务（恢复const引用）
-void submit_tasks(const std::vector<LangTask>& tasks) {
-    std::lock_guard<std::mutex> lock(g_task_mutex);
-    g_tasks = tasks;
+void ThreadPool::finish_item(Item& item) {
+    if (--item.batch->remaining == 0) {
+        item.batch->done.set_value();
+    }
 }
 
-// 获取所有识别结果
-std::vector<OcrResult> get_all_results() {
+void ThreadPool::worker_loop(int worker_id) {
+    trace_thread_name("ocr-worker-" + std::to_string(worker_id));
+    if (m_on_start) m_on_start(worker_id);
+
+    std::string cur_affinity;
     while (true) {
-        std::lock_guard<std::mutex> lock(g_task_mutex);
-        if (g_tasks.empty()) break;
-        usleep(100000);
-    }
+        Item item;
+        if (pop_local(worker_id, item) || steal(worker_id, cur_affinity, item)) {
+            cur_affinity = item.task.affinity;
+            try {
+                TraceScope scope(TRACE_TASK, cur_affinity);
+                item.task.run(worker_id);
+            } catch (const std::exception& e) {
+                std::cerr << "线程" << worker_id << "执行任务异常：" << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "线程" << worker_id << "执行任务异常（未知异常类型）" << std::endl;
+            }
+            finish_item(item);
+            continue;
+        }
 
-    g_stop = true;
-    for (int i = 0; i < g_thread_num; i++) {
-        pthread_join(g_threads[i], nullptr);
+        // 无任务可取时阻塞等待新提交或停止信号；停止时先处理完剩余任务
+        uint64_t idle_begin = trace_active() ? trace_now_us() : 0;
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+        if (trace_active()) trace_span(TRACE_IDLE, idle_begin, trace_now_us());
+        if (m_stop && m_queued.load() <= 0) break;
     }
 
-    return g_all_results;
+    if (m_on_exit) m_on_exit(worker_id);
 }
-
-// 销毁线程池
-void destroy_thread_pool() {
-    if (g_threads) {
-        delete[] g_threads;
-        g_threads = nullptr;
-    }
-    g_thread_num = 0;
-    g_all_results.clear();
-}
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "trace.h"
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+bool g_trace_active = false;
+
+static bool g_trace_events = false;
+static bool g_trace_stats = false;
+static size_t g_ring_events = 1 << 16;
+static std::chrono::steady_clock::time_point g_trace_epoch = std::chrono::steady_clock::now();
+
+// 语种编码登记表（直方图与事件中只保存编号）
+static const int TRACE_MAX_LANGS = 32;
+static std::mutex g_lang_mutex;
+static std::vector<std::string> g_lang_names;
+
+// 对数直方图：第b档为[2^(b-1), 2^b)微秒，第0档为0微秒
+static const int HIST_BUCKETS = 40;
+struct Histogram {
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+    uint64_t buckets[HIST_BUCKETS] = {};
+};
+
+struct CounterStat {
+    uint64_t samples = 0;
+    int64_t sum = 0;
+    int64_t max = 0;
+};
+
+// 单个事件：耗时段（dur_or_value为时长）或队列深度采样（为采样值）
+struct TraceEvent {
+    uint64_t ts_us;
+    int64_t dur_or_value;
+    uint8_t is_counter;
+    uint8_t id;         // TraceStage或TraceCounter
+    int16_t lang;       // 语种编号，-1表示不区分
+};
+
+// 线程私有记录：只由所属线程写入，无锁；由登记表持有，线程退出后仍可导出
+struct ThreadTrace {
+    int tid = 0;
+    std::string name;
+    std::vector<TraceEvent> ring;
+    uint64_t written = 0;               // 累计写入事件数（超过容量后覆盖最早的事件）
+    std::vector<Histogram> hist;        // [stage * (TRACE_MAX_LANGS + 1) + lang]，不区分语种的记在最后一列
+    CounterStat counters[TRACE_COUNTER_NUM];
+};
+
+static std::mutex g_registry_mutex;
+static std::vector<std::shared_ptr<ThreadTrace>> g_registry;
+static thread_local ThreadTrace* t_trace = nullptr;
+static thread_local std::map<std::string, int> t_lang_ids;
+
+static const char* STAGE_NAMES[TRACE_STAGE_NUM] = {
+    "lookup", "decode", "cache", "engine_init", "engine_switch", "preprocess",
+    "recognize", "match", "annotate", "pdf_emit", "pdf_save", "task", "idle"
+};
+
+static const char* COUNTER_NAMES[TRACE_COUNTER_NUM] = {
+    "rows_queue", "resolved_queue", "decoded_queue", "result_queue", "inflight_units", "reorder_waiting"
+};
+
+void trace_setup(bool events, bool stats, size_t ring_events) {
+    g_trace_events = events;
+    g_trace_stats = stats;
+    g_ring_events = std::max<size_t>(ring_events, 1024);
+    g_trace_epoch = std::chrono::steady_clock::now();
+    g_trace_active = events || stats;
+}
+
+uint64_t trace_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_trace_epoch).count();
+}
+
+// 当前线程的记录（首次使用时登记）
+static ThreadTrace& thread_trace() {
+    if (t_trace) return *t_trace;
+    std::shared_ptr<ThreadTrace> trace(new ThreadTrace());
+    if (g_trace_events) trace->ring.resize(g_ring_events);
+    if (g_trace_stats) trace->hist.resize(TRACE_STAGE_NUM * (TRACE_MAX_LANGS + 1));
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    trace->tid = (int)g_registry.size() + 1;
+    trace->name = "thread-" + std::to_string(trace->tid);
+    g_registry.push_back(trace);
+    t_trace = trace.get();
+    return *t_trace;
+}
+
+// 语种编码 -> 编号（线程内缓存，只有首次遇到的语种需要加锁登记）
+static int lang_id(const std::string& lang_code) {
+    if (lang_code.empty()) return -1;
+    auto it = t_lang_ids.find(lang_code);
+    if (it != t_lang_ids.end()) return it->second;
+
+    int id = -1;
+    {
+        std::lock_guard<std::mutex> lock(g_lang_mutex);
+        auto found = std::find(g_lang_names.begin(), g_lang_names.end(), lang_code);
+        if (found != g_lang_names.end()) {
+            id = (int)(found - g_lang_names.begin());
+        } else if ((int)g_lang_names.size() < TRACE_MAX_LANGS) {
+            id = (int)g_lang_names.size();
+            g_lang_names.push_back(lang_code);
+        }
+    }
+    t_lang_ids[lang_code] = id;
+    return id;
+}
+
+static void push_event(ThreadTrace& trace, const TraceEvent& event) {
+    trace.ring[trace.written % trace.ring.size()] = event;
+    trace.written++;
+}
+
+void trace_thread_name(const std::string& name) {
+    if (!g_trace_active) return;
+    thread_trace().name = name;
+}
+
+void trace_span(TraceStage stage, uint64_t begin_us, uint64_t end_us, const std::string& lang_code) {
+    if (!g_trace_active) return;
+    ThreadTrace& trace = thread_trace();
+    int lang = lang_id(lang_code);
+    uint64_t dur = (end_us > begin_us) ? end_us - begin_us : 0;
+
+    if (g_trace_events) {
+        TraceEvent event;
+        event.ts_us = begin_us;
+        event.dur_or_value = (int64_t)dur;
+        event.is_counter = 0;
+        event.id = (uint8_t)stage;
+        event.lang = (int16_t)lang;
+        push_event(trace, event);
+    }
+    if (g_trace_stats) {
+        Histogram& hist = trace.hist[stage * (TRACE_MAX_LANGS + 1) + (lang < 0 ? TRACE_MAX_LANGS : lang)];
+        int bucket = 0;
+        while (bucket < HIST_BUCKETS - 1 && (1ull << bucket) <= dur) bucket++;
+        hist.count++;
+        hist.total_us += dur;
+        hist.max_us = std::max(hist.max_us, dur);
+        hist.buckets[bucket]++;
+    }
+}
+
+void trace_counter(TraceCounter counter, int64_t value) {
+    if (!g_trace_active) return;
+    ThreadTrace& trace = thread_trace();
+    if (g_trace_events) {
+        TraceEvent event;
+        event.ts_us = trace_now_us();
+        event.dur_or_value = value;
+        event.is_counter = 1;
+        event.id = (uint8_t)counter;
+        event.lang = -1;
+        push_event(trace, event);
+    }
+    CounterStat& stat = trace.counters[counter];
+    stat.samples++;
+    stat.sum += value;
+    stat.max = std::max(stat.max, value);
+}
+
+static void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+bool trace_write_chrome(const std::string& path) {
+    if (!g_trace_events) return false;
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "无法写入追踪文件：" << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::shared_ptr<ThreadTrace>> traces;
+    std::vector<std::string> lang_names;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        traces = g_registry;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_lang_mutex);
+        lang_names = g_lang_names;
+    }
+
+    // Chrome Trace Event格式：耗时段用"X"，队列深度用"C"，线程名用元数据"M"
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    uint64_t dropped = 0;
+    for (const auto& trace : traces) {
+        out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid
+            << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        write_json_string(out, trace->name);
+        out << "}}";
+        first = false;
+
+        size_t cap = trace->ring.size();
+        uint64_t begin = (trace->written > cap) ? trace->written - cap : 0;
+        dropped += begin;
+        for (uint64_t i = begin; i < trace->written; i++) {
+            const TraceEvent& event = trace->ring[i % cap];
+            if (event.is_counter) {
+                out << ",\n{\"ph\":\"C\",\"pid\":1,\"tid\":" << trace->tid << ",\"ts\":" << event.ts_us
+                    << ",\"name\":\"" << COUNTER_NAMES[event.id] << "\",\"args\":{\"value\":" << event.dur_or_value << "}}";
+            } else {
+                out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << trace->tid << ",\"ts\":" << event.ts_us
+                    << ",\"dur\":" << event.dur_or_value << ",\"name\":\"" << STAGE_NAMES[event.id] << "\"";
+                if (event.lang >= 0 && event.lang < (int)lang_names.size()) {
+                    out << ",\"args\":{\"lang\":";
+                    write_json_string(out, lang_names[event.lang]);
+                    out << "}";
+                }
+                out << "}";
+            }
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        std::cerr << "写入追踪文件失败：" << path << std::endl;
+        return false;
+    }
+    if (dropped > 0) {
+        std::cout << "追踪环形缓冲区已覆盖最早的" << dropped << "个事件" << std::endl;
+    }
+    std::cout << "追踪文件已生成：" << path << std::endl;
+    return true;
+}
+
+// 按直方图估算分位数（档内线性插值，不超过最大值）
+static double hist_percentile(const Histogram& hist, double p) {
+    if (hist.count == 0) return 0;
+    double rank = p * hist.count;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if (hist.buckets[b] == 0) continue;
+        if (seen + hist.buckets[b] >= rank) {
+            double low = (b == 0) ? 0 : (double)(1ull << (b - 1));
+            double high = (b == 0) ? 0 : (double)(1ull << b);
+            double value = low + (high - low) * (rank - seen) / hist.buckets[b];
+            return std::min(value, (double)hist.max_us);
+        }
+        seen += hist.buckets[b];
+    }
+    return (double)hist.max_us;
+}
+
+void trace_print_stats(std::ostream& out) {
+    if (!g_trace_stats) return;
+    std::vector<std::shared_ptr<ThreadTrace>> traces;
+    std::vector<std::string> lang_names;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        traces = g_registry;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_lang_mutex);
+        lang_names = g_lang_names;
+    }
+
+    // 合并各线程直方图
+    std::vector<Histogram> merged(TRACE_STAGE_NUM * (TRACE_MAX_LANGS + 1));
+    CounterStat counters[TRACE_COUNTER_NUM];
+    for (const auto& trace : traces) {
+        for (size_t i = 0; i < trace->hist.size(); i++) {
+            const Histogram& from = trace->hist[i];
+            Histogram& to = merged[i];
+            to.count += from.count;
+            to.total_us += from.total_us;
+            to.max_us = std::max(to.max_us, from.max_us);
+            for (int b = 0; b < HIST_BUCKETS; b++) to.buckets[b] += from.buckets[b];
+        }
+        for (int c = 0; c < TRACE_COUNTER_NUM; c++) {
+            counters[c].samples += trace->counters[c].samples;
+            counters[c].sum += trace->counters[c].sum;
+            counters[c].max = std::max(counters[c].max, trace->counters[c].max);
+        }
+    }
+
+    out << "==================== 阶段耗时统计（毫秒） ====================" << std::endl;
+    out << std::left << std::setw(16) << "阶段" << std::setw(8) << "语种" << std::right
+        << std::setw(10) << "次数" << std::setw(12) << "合计" << std::setw(10) << "平均"
+        << std::setw(10) << "P50" << std::setw(10) << "P90" << std::setw(10) << "P99" << std::setw(10) << "最大" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (int stage = 0; stage < TRACE_STAGE_NUM; stage++) {
+        if (stage == TRACE_TASK || stage == TRACE_IDLE) continue;
+        for (int lang = 0; lang <= TRACE_MAX_LANGS; lang++) {
+            const Histogram& hist = merged[stage * (TRACE_MAX_LANGS + 1) + lang];
+            if (hist.count == 0) continue;
+            std::string lang_name = (lang < (int)lang_names.size()) ? lang_names[lang] : "-";
+            out << std::left << std::setw(16) << STAGE_NAMES[stage] << std::setw(8) << lang_name << std::right
+                << std::setw(10) << hist.count
+                << std::setw(12) << hist.total_us / 1000.0
+                << std::setw(10) << (double)hist.total_us / hist.count / 1000.0
+                << std::setw(10) << hist_percentile(hist, 0.50) / 1000.0
+                << std::setw(10) << hist_percentile(hist, 0.90) / 1000.0
+                << std::setw(10) << hist_percentile(hist, 0.99) / 1000.0
+                << std::setw(10) << hist.max_us / 1000.0 << std::endl;
+        }
+    }
+
+    // 线程池线程的忙碌/空闲时间（执行任务 vs 等待任务）
+    out << "-------------------- 线程忙碌/空闲（秒） --------------------" << std::endl;
+    for (const auto& trace : traces) {
+        uint64_t busy = 0;
+        uint64_t idle = 0;
+        for (int lang = 0; lang <= TRACE_MAX_LANGS; lang++) {
+            busy += trace->hist[TRACE_TASK * (TRACE_MAX_LANGS + 1) + lang].total_us;
+            idle += trace->hist[TRACE_IDLE * (TRACE_MAX_LANGS + 1) + lang].total_us;
+        }
+        if (busy + idle == 0) continue;
+        out << std::left << std::setw(20) << trace->name << std::right
+            << "忙碌" << std::setw(10) << busy / 1e6
+            << "  空闲" << std::setw(10) << idle / 1e6
+            << "  利用率" << std::setw(7) << std::setprecision(1) << 100.0 * busy / (busy + idle) << "%"
+            << std::setprecision(3) << std::endl;
+    }
+
+    out << "-------------------- 队列深度 --------------------" << std::endl;
+    for (int c = 0; c < TRACE_COUNTER_NUM; c++) {
+        if (counters[c].samples == 0) continue;
+        out << std::left << std::setw(20) << COUNTER_NAMES[c] << std::right
+            << "平均" << std::setw(10) << (double)counters[c].sum / counters[c].samples
+            << "  最大" << std::setw(8) << counters[c].max
+            << "  采样" << std::setw(10) << counters[c].samples << std::endl;
+    }
+    out.unsetf(std::ios::fixed);
+    out << std::setprecision(6);
+}
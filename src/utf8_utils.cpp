@@ -0,0 +1,169 @@
+#include "utf8_utils.h"
+#include <algorithm>
+
+char32_t utf8_next(std::string_view text, size_t& pos) {
+    size_t n = text.size();
+    unsigned char c = text[pos];
+    char32_t cp;
+    int len;
+    if (c < 0x80) {
+        pos++;
+        return c;
+    } else if ((c & 0xE0) == 0xC0) {
+        cp = c & 0x1F;
+        len = 2;
+    } else if ((c & 0xF0) == 0xE0) {
+        cp = c & 0x0F;
+        len = 3;
+    } else if ((c & 0xF8) == 0xF0) {
+        cp = c & 0x07;
+        len = 4;
+    } else {
+        pos++;
+        return 0xFFFD;
+    }
+    if (pos + len > n) {
+        pos = n;
+        return 0xFFFD;
+    }
+    for (int k = 1; k < len; k++) {
+        unsigned char cc = text[pos + k];
+        if ((cc & 0xC0) != 0x80) {
+            pos++;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    pos += len;
+    return cp;
+}
+
+std::u32string utf8_decode(const std::string& text) {
+    std::u32string out;
+    out.reserve(text.size());
+    size_t i = 0;
+    while (i < text.size()) {
+        out.push_back(utf8_next(text, i));
+    }
+    return out;
+}
+
+void utf8_append(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+std::string utf8_encode(const std::u32string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char32_t cp : text) utf8_append(out, cp);
+    return out;
+}
+
+char32_t fold_case(char32_t cp, bool turkish) {
+    if (cp < 0x80) {
+        if (cp == 'I' && turkish) return 0x0131;   // I -> ı
+        return (cp >= 'A' && cp <= 'Z') ? cp + 0x20 : cp;
+    }
+    // Latin-1补充（À-Þ，跳过×）
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+    // 拉丁扩展A
+    if (cp == 0x0130) return 'i';                  // İ -> i
+    if (cp == 0x0178) return 0x00FF;               // Ÿ -> ÿ
+    if ((cp >= 0x0100 && cp <= 0x012F) || (cp >= 0x0132 && cp <= 0x0137) || (cp >= 0x014A && cp <= 0x0177)) {
+        return (cp % 2 == 0) ? cp + 1 : cp;
+    }
+    if ((cp >= 0x0139 && cp <= 0x0148) || (cp >= 0x0179 && cp <= 0x017E)) {
+        return (cp % 2 == 1) ? cp + 1 : cp;
+    }
+    // 希腊字母
+    if (cp >= 0x0391 && cp <= 0x03A9 && cp != 0x03A2) return cp + 0x20;
+    // 西里尔字母
+    if (cp >= 0x0410 && cp <= 0x042F) return cp + 0x20;
+    if (cp >= 0x0400 && cp <= 0x040F) return cp + 0x50;
+    return cp;
+}
+
+// 组合表：基字符 + 组合附加符 -> 预组合字符（按前两列排序，便于二分查找）
+struct Composition {
+    char32_t base;
+    char32_t mark;
+    char32_t composed;
+};
+
+static const Composition COMPOSITIONS[] = {
+    {0x0041, 0x0300, 0x00C0}, {0x0041, 0x0301, 0x00C1}, {0x0041, 0x0302, 0x00C2}, {0x0041, 0x0303, 0x00C3}, {0x0041, 0x0308, 0x00C4}, {0x0041, 0x030A, 0x00C5},
+    {0x0043, 0x0327, 0x00C7},
+    {0x0045, 0x0300, 0x00C8}, {0x0045, 0x0301, 0x00C9}, {0x0045, 0x0302, 0x00CA}, {0x0045, 0x0308, 0x00CB},
+    {0x0047, 0x0306, 0x011E},
+    {0x0049, 0x0300, 0x00CC}, {0x0049, 0x0301, 0x00CD}, {0x0049, 0x0302, 0x00CE}, {0x0049, 0x0307, 0x0130}, {0x0049, 0x0308, 0x00CF},
+    {0x004E, 0x0303, 0x00D1},
+    {0x004F, 0x0300, 0x00D2}, {0x004F, 0x0301, 0x00D3}, {0x004F, 0x0302, 0x00D4}, {0x004F, 0x0303, 0x00D5}, {0x004F, 0x0308, 0x00D6},
+    {0x0053, 0x0327, 0x015E},
+    {0x0055, 0x0300, 0x00D9}, {0x0055, 0x0301, 0x00DA}, {0x0055, 0x0302, 0x00DB}, {0x0055, 0x0308, 0x00DC},
+    {0x0059, 0x0301, 0x00DD}, {0x0059, 0x0308, 0x0178},
+    {0x0061, 0x0300, 0x00E0}, {0x0061, 0x0301, 0x00E1}, {0x0061, 0x0302, 0x00E2}, {0x0061, 0x0303, 0x00E3}, {0x0061, 0x0308, 0x00E4}, {0x0061, 0x030A, 0x00E5},
+    {0x0063, 0x0327, 0x00E7},
+    {0x0065, 0x0300, 0x00E8}, {0x0065, 0x0301, 0x00E9}, {0x0065, 0x0302, 0x00EA}, {0x0065, 0x0308, 0x00EB},
+    {0x0067, 0x0306, 0x011F},
+    {0x0069, 0x0300, 0x00EC}, {0x0069, 0x0301, 0x00ED}, {0x0069, 0x0302, 0x00EE}, {0x0069, 0x0308, 0x00EF},
+    {0x006E, 0x0303, 0x00F1},
+    {0x006F, 0x0300, 0x00F2}, {0x006F, 0x0301, 0x00F3}, {0x006F, 0x0302, 0x00F4}, {0x006F, 0x0303, 0x00F5}, {0x006F, 0x0308, 0x00F6},
+    {0x0073, 0x0327, 0x015F},
+    {0x0075, 0x0300, 0x00F9}, {0x0075, 0x0301, 0x00FA}, {0x0075, 0x0302, 0x00FB}, {0x0075, 0x0308, 0x00FC},
+    {0x0079, 0x0301, 0x00FD}, {0x0079, 0x0308, 0x00FF},
+    {0x0415, 0x0308, 0x0401}, {0x0418, 0x0306, 0x0419},
+    {0x0435, 0x0308, 0x0451}, {0x0438, 0x0306, 0x0439},
+    {0x0627, 0x0653, 0x0622}, {0x0627, 0x0654, 0x0623}, {0x0627, 0x0655, 0x0625},
+    {0x0648, 0x0654, 0x0624}, {0x064A, 0x0654, 0x0626},
+};
+
+static bool is_combining_mark(char32_t cp) {
+    return (cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x0653 && cp <= 0x0655);
+}
+
+std::u32string compose_nfc(const std::u32string& text) {
+    static const Composition* begin = COMPOSITIONS;
+    static const Composition* end = COMPOSITIONS + sizeof(COMPOSITIONS) / sizeof(COMPOSITIONS[0]);
+
+    std::u32string out;
+    out.reserve(text.size());
+    for (char32_t cp : text) {
+        if (!out.empty() && is_combining_mark(cp)) {
+            Composition key = {out.back(), cp, 0};
+            const Composition* it = std::lower_bound(begin, end, key, [](const Composition& a, const Composition& b) {
+                return a.base != b.base ? a.base < b.base : a.mark < b.mark;
+            });
+            if (it != end && it->base == key.base && it->mark == key.mark) {
+                out.back() = it->composed;
+                continue;
+            }
+        }
+        out.push_back(cp);
+    }
+    return out;
+}
+
+bool is_space_cp(char32_t cp) {
+    return cp == ' ' || (cp >= 0x09 && cp <= 0x0D) || cp == 0x00A0 || cp == 0x1680 ||
+           (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 || cp == 0x2029 ||
+           cp == 0x202F || cp == 0x205F || cp == 0x3000;
+}
+
+bool is_format_cp(char32_t cp) {
+    return (cp >= 0x200B && cp <= 0x200F) || (cp >= 0x202A && cp <= 0x202E) ||
+           (cp >= 0x2066 && cp <= 0x2069) || cp == 0x00AD || cp == 0xFEFF;
+}